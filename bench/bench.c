@@ -0,0 +1,415 @@
+// chip8_bench: mede a velocidade do núcleo e grava o resultado em JSON.
+//
+// Três tipos de medida:
+//  - opcode: laços curtos com uma família de instruções (ALU 8XYn, DXYN em
+//    várias alturas, Fx55/Fx65, desvios, CALL/RET), em MIPS;
+//  - rom:    ROMs inteiras em modo turbo, em MIPS;
+//  - render: conversão do framebuffer para ARGB (a parte de CPU do
+//            render_screen()) em 64x32 e 128x64 e rolagem da tela em
+//            128x64, em ns por frame; também os filtros de upscale.h
+//            ampliando para 1920x1080.
+//
+// Com --check-jit roda os programas de opcode e as ROMs nos dois motores e
+// sai com erro se o estado final divergir ou se o JIT for mais lento que o
+// interpretador em alguma ROM. Nos laços de opcode a velocidade só é
+// informada: os que vivem de helpers (DXYN, FX55) ficam perto de 1x.
+//
+// Uso: chip8_bench [--jit | --check-jit] [--quirks PERFIL] [--quick]
+//                  [--out ARQUIVO] [rom...]
+// Sem ROMs na linha de comando usa as ROMs de CHIP8_BENCH_ROM_DIR.
+#include "arena.h"
+#include "cpu.h"
+#include "files.h"
+#include "framebuffer.h"
+#include "jit.h"
+#include "pack.h"
+#include "sched.h"
+#include "upscale.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef CHIP8_BENCH_ROM_DIR
+#define CHIP8_BENCH_ROM_DIR "test"
+#endif
+
+#define BENCH_REPEAT 3  // Melhor de N execuções
+#define BENCH_UNROLL 32 // Cópias da instrução medida por volta do laço
+#define BENCH_UPSCALE_WIDTH 1920
+#define BENCH_UPSCALE_HEIGHT 1080
+#define BENCH_UPSCALE_DIVISOR 100 // Frames de upscale = render_frames / N
+
+typedef struct {
+  const char *name;
+  uint16_t setup[4]; // Executadas uma vez antes do laço (0 = fim)
+  uint16_t body[8];  // Sequência repetida BENCH_UNROLL vezes (0 = fim)
+} OpcodeBench;
+
+// V0 = V1 = 0 e I = 0 (fontes) no power-on, salvo o que o setup mudar
+static const OpcodeBench opcode_benches[] = {
+    {"alu_8xy4", {0}, {0x8014}},
+    {"alu_mix",
+     {0x6105},
+     {0x8010, 0x8011, 0x8012, 0x8013, 0x8014, 0x8015, 0x8016, 0x801E}},
+    {"drw_h1", {0}, {0xD011}},
+    {"drw_h8", {0}, {0xD018}},
+    {"drw_h15", {0}, {0xD01F}},
+    {"fx55", {0xA800}, {0xFF55}},
+    {"fx65", {0xA800}, {0xFF65}},
+    // 3XNN/4XNN/5XY0 tomados e não tomados; o 6000 saltado mantém o ritmo
+    {"branch",
+     {0},
+     {0x3000, 0x6000, 0x3001, 0x4001, 0x6000, 0x4000, 0x5010, 0x6000}},
+    {"ld_i_add_i", {0x6301}, {0xA800, 0xF31E}},
+};
+
+typedef struct {
+  bool use_jit;
+  bool check_jit; // Compara os dois motores em vez de medir um só
+  uint64_t opcode_cycles;
+  uint64_t rom_cycles;
+  uint64_t render_frames;
+  FILE *out;
+  bool first;
+  int failures; // Divergências ou JIT mais lento (--check-jit)
+} Bench;
+
+static double now_seconds(void) {
+  struct timespec now;
+  timespec_get(&now, TIME_UTC);
+  return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static void emit_result(Bench *bench, const char *kind, const char *name,
+                        uint64_t work, double seconds) {
+  fprintf(bench->out, "%s\n    {\"kind\": \"%s\", \"name\": \"%s\", ",
+          bench->first ? "" : ",", kind, name);
+  if (strcmp(kind, "render") == 0) {
+    fprintf(bench->out,
+            "\"frames\": %llu, \"seconds\": %.6f, \"ns_per_frame\": %.1f}",
+            (unsigned long long)work, seconds,
+            work ? seconds * 1e9 / work : 0.0);
+  } else {
+    fprintf(bench->out,
+            "\"cycles\": %llu, \"seconds\": %.6f, \"mips\": %.2f}",
+            (unsigned long long)work, seconds,
+            seconds > 0 ? work / seconds / 1e6 : 0.0);
+  }
+  bench->first = false;
+}
+
+// Estado visível do convidado ao fim da execução: registradores, pilha,
+// timers, memória e tela
+static uint64_t state_hash(const CPU *chip) {
+  uint64_t hash = screen_hash(chip);
+  hash ^= pack_hash(chip->v, sizeof(chip->v));
+  hash = hash * 31 + chip->i;
+  hash = hash * 31 + chip->pc;
+  hash = hash * 31 + chip->sp;
+  hash = hash * 31 + chip->delay_timer;
+  hash = hash * 31 + chip->sound_timer;
+  hash ^= pack_hash((const uint8_t *)chip->stack, sizeof(chip->stack));
+  return hash ^ pack_hash(chip->dram.memory, MEMORY_SIZE);
+}
+
+// Roda o mesmo programa BENCH_REPEAT vezes a partir do power-on e fica com
+// o menor tempo. Se hash não for NULL recebe o estado final.
+static double run_program(CpuArena *arena, bool use_jit, const uint8_t *rom,
+                          size_t size, uint64_t cycles, uint64_t *hash) {
+  Scheduler sched;
+  initScheduler(&sched);
+  sched.turbo = true;
+  sched.idle_skip = false; // Mede as instruções, não o tempo pulado
+
+  double best = 0;
+  for (int r = 0; r < BENCH_REPEAT; r++) {
+    arena_reset(arena, 0);
+    CPU *chip = arena_get(arena, 0);
+    if (!use_jit && chip->jit) {
+      jit_destroy(chip->jit);
+      chip->jit = NULL;
+    }
+    if (!initROMData(chip, rom, size)) {
+      return 0;
+    }
+    if (use_jit && chip->jit == NULL) {
+      chip->jit = jit_create();
+    }
+    double start = now_seconds();
+    run_cycles(chip, &sched, cycles);
+    double seconds = now_seconds() - start;
+    if (r == 0 || seconds < best) {
+      best = seconds;
+    }
+    if (hash) {
+      *hash = state_hash(chip);
+    }
+  }
+  return best;
+}
+
+// Mesmo programa no interpretador e no JIT: o estado final deve ser igual
+// e, se check_speed, o JIT não pode ser mais lento
+static void check_jit(Bench *bench, CpuArena *arena, const char *name,
+                      const uint8_t *rom, size_t size, uint64_t cycles,
+                      bool check_speed) {
+  uint64_t interp_hash = 0, jit_hash = 0;
+  double interp = run_program(arena, false, rom, size, cycles, &interp_hash);
+  double jit = run_program(arena, true, rom, size, cycles, &jit_hash);
+  bool same = interp_hash == jit_hash;
+  double speedup = jit > 0 ? interp / jit : 0.0;
+  fprintf(bench->out,
+          "%s\n    {\"kind\": \"jit_check\", \"name\": \"%s\", "
+          "\"cycles\": %llu, \"interpreter_mips\": %.2f, "
+          "\"jit_mips\": %.2f, \"speedup\": %.2f, \"same_state\": %s}",
+          bench->first ? "" : ",", name, (unsigned long long)cycles,
+          interp > 0 ? cycles / interp / 1e6 : 0.0,
+          jit > 0 ? cycles / jit / 1e6 : 0.0, speedup,
+          same ? "true" : "false");
+  bench->first = false;
+  if (!same || (check_speed && speedup < 1.0)) {
+    fprintf(stderr, "Erro: JIT %s em %s (%.2fx)\n",
+            same ? "mais lento que o interpretador" : "diverge do interpretador",
+            name, speedup);
+    bench->failures++;
+  }
+}
+
+static void measure_program(Bench *bench, CpuArena *arena, const char *kind,
+                            const char *name, const uint8_t *rom, size_t size,
+                            uint64_t cycles) {
+  if (bench->check_jit) {
+    check_jit(bench, arena, name, rom, size, cycles, strcmp(kind, "rom") == 0);
+    return;
+  }
+  double seconds = run_program(arena, bench->use_jit, rom, size, cycles, NULL);
+  emit_result(bench, kind, name, cycles, seconds);
+}
+
+static size_t put_op(uint8_t *rom, size_t at, uint16_t op) {
+  rom[at] = op >> 8;
+  rom[at + 1] = op & 0xFF;
+  return at + 2;
+}
+
+static void run_opcode_benches(Bench *bench, CpuArena *arena) {
+  uint8_t rom[MEMORY_SIZE - ROM_START_ADDRESS];
+  size_t count = sizeof(opcode_benches) / sizeof(opcode_benches[0]);
+  for (size_t b = 0; b < count; b++) {
+    const OpcodeBench *spec = &opcode_benches[b];
+    size_t size = 0;
+    for (int s = 0; s < 4 && spec->setup[s]; s++) {
+      size = put_op(rom, size, spec->setup[s]);
+    }
+    uint16_t loop = ROM_START_ADDRESS + size;
+    for (int u = 0; u < BENCH_UNROLL; u++) {
+      for (int s = 0; s < 8 && spec->body[s]; s++) {
+        size = put_op(rom, size, spec->body[s]);
+      }
+    }
+    size = put_op(rom, size, 0x1000 | loop);
+
+    measure_program(bench, arena, "opcode", spec->name, rom, size,
+                    bench->opcode_cycles);
+  }
+
+  // CALL/RET: 2NNN, 1NNN e 00EE por volta
+  size_t size = 0;
+  size = put_op(rom, size, 0x2206);
+  size = put_op(rom, size, 0x1200);
+  size = put_op(rom, size, 0x0000);
+  size = put_op(rom, size, 0x00EE);
+  measure_program(bench, arena, "opcode", "call_ret", rom, size,
+                  bench->opcode_cycles);
+}
+
+static void run_rom_bench(Bench *bench, CpuArena *arena, const char *path) {
+  FILEDRAM *file = initFILE(path);
+  if (file == NULL) {
+    return;
+  }
+  const char *name = strrchr(path, '/');
+  name = name ? name + 1 : path;
+  measure_program(bench, arena, "rom", name, file->buffer, (size_t)file->size,
+                  bench->rom_cycles);
+  freeFILE(file);
+}
+
+static void fill_screen(Screen *screen, bool hires) {
+  memset(screen, 0, sizeof(*screen));
+  screen->hires = hires;
+  for (int y = 0; y < HIRES_HEIGHT; y++) {
+    for (int w = 0; w < ROW_WORDS; w++) {
+      screen->rows[0][y][w] = 0xAAAAAAAAAAAAAAAAull >> (y & 1);
+    }
+  }
+}
+
+static void run_render_bench(Bench *bench, bool hires) {
+  static uint32_t pixels[FRAMEBUFFER_WIDTH * FRAMEBUFFER_HEIGHT];
+  static Screen screen;
+  fill_screen(&screen, hires);
+
+  double start = now_seconds();
+  volatile uint32_t sink = 0;
+  for (uint64_t f = 0; f < bench->render_frames; f++) {
+    // Muda a tela a cada frame para o compilador não eliminar o laço
+    screen.rows[0][f % SCREEN_HEIGHT][0] ^= f;
+    framebuffer_to_argb(&screen, pixels, FRAMEBUFFER_WIDTH * sizeof(uint32_t));
+    sink += pixels[f % (FRAMEBUFFER_WIDTH * FRAMEBUFFER_HEIGHT)];
+  }
+  double seconds = now_seconds() - start;
+  emit_result(bench, "render",
+              hires ? "framebuffer_to_argb_hires" : "framebuffer_to_argb",
+              bench->render_frames, seconds);
+}
+
+// 00CN, 00FB, 00FC e 00DN em 128x64 com os dois planos; um "frame" aqui é
+// uma rodada das quatro rolagens
+static void run_scroll_bench(Bench *bench) {
+  static Screen screen;
+  fill_screen(&screen, true);
+
+  double start = now_seconds();
+  volatile uint64_t sink = 0;
+  for (uint64_t f = 0; f < bench->render_frames; f++) {
+    screen_scroll_down(&screen, 0x3, 1);
+    screen_scroll_right(&screen, 0x3);
+    screen_scroll_left(&screen, 0x3);
+    screen_scroll_up(&screen, 0x3, 1);
+    screen.rows[0][0][0] ^= f;
+    sink += screen.rows[0][f % HIRES_HEIGHT][f % ROW_WORDS];
+  }
+  double seconds = now_seconds() - start;
+  emit_result(bench, "render", "scroll_hires", bench->render_frames, seconds);
+}
+
+// Um filtro ampliando a tela em alta resolução para 1920x1080 (fator 15,
+// 1920x960); é o custo de CPU de cada apresentação no frontend
+static void run_upscale_bench(Bench *bench, int filter) {
+  static Screen screen;
+  fill_screen(&screen, true);
+  Upscaler upscaler;
+  if (!upscaler_init(&upscaler, filter)) {
+    return;
+  }
+  upscaler_resize(&upscaler, BENCH_UPSCALE_WIDTH, BENCH_UPSCALE_HEIGHT);
+  int width, height;
+  upscaler_output_size(&upscaler, &screen, &width, &height);
+  uint32_t *pixels =
+      (uint32_t *)malloc((size_t)width * height * sizeof(uint32_t));
+  if (pixels == NULL) {
+    upscaler_free(&upscaler);
+    return;
+  }
+
+  uint64_t frames = bench->render_frames / BENCH_UPSCALE_DIVISOR;
+  double start = now_seconds();
+  volatile uint32_t sink = 0;
+  for (uint64_t f = 0; f < frames; f++) {
+    screen.rows[0][f % HIRES_HEIGHT][0] ^= f;
+    upscaler_run(&upscaler, &screen, pixels, width * sizeof(uint32_t));
+    sink += pixels[f % ((size_t)width * height)];
+  }
+  double seconds = now_seconds() - start;
+  char name[64];
+  snprintf(name, sizeof(name), "upscale_%s_1080p_%s",
+           upscale_filter_name(filter), upscaler.kernel);
+  emit_result(bench, "render", name, frames, seconds);
+  free(pixels);
+  upscaler_free(&upscaler);
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr, "Uso: %s [opções] [rom...]\n", prog);
+  fprintf(stderr, "  --jit          Usa o recompilador x86-64\n");
+  fprintf(stderr, "  --check-jit    Compara JIT e interpretador (estado e "
+                  "velocidade)\n");
+  fprintf(stderr, "  --quirks P     Perfil do interpretador (padrão: legacy)\n");
+  fprintf(stderr, "  --quick        Execuções 10x menores\n");
+  fprintf(stderr, "  --out ARQUIVO  Grava o JSON em ARQUIVO (padrão: saída "
+                  "padrão)\n");
+}
+
+int main(int argc, char **argv) {
+  Bench bench = {false, false, 20000000, 50000000, 200000, stdout, true, 0};
+  const char *out_path = NULL;
+  int quirks = QUIRKS_LEGACY;
+  const char **roms = (const char **)calloc(argc, sizeof(char *));
+  int rom_count = 0;
+
+  for (int a = 1; a < argc; a++) {
+    if (strcmp(argv[a], "--jit") == 0) {
+      bench.use_jit = true;
+    } else if (strcmp(argv[a], "--check-jit") == 0) {
+      bench.check_jit = true;
+    } else if (strcmp(argv[a], "--quirks") == 0 && a + 1 < argc) {
+      quirks = quirks_from_name(argv[++a]);
+      if (quirks < 0) {
+        fprintf(stderr, "Erro: Perfil desconhecido: %s\n", argv[a]);
+        return -1;
+      }
+    } else if (strcmp(argv[a], "--quick") == 0) {
+      bench.opcode_cycles /= 10;
+      bench.rom_cycles /= 10;
+      bench.render_frames /= 10;
+    } else if (strcmp(argv[a], "--out") == 0 && a + 1 < argc) {
+      out_path = argv[++a];
+    } else if (argv[a][0] == '-' && argv[a][1] == '-') {
+      usage(argv[0]);
+      return -1;
+    } else {
+      roms[rom_count++] = argv[a];
+    }
+  }
+  if (rom_count == 0) {
+    roms[rom_count++] = CHIP8_BENCH_ROM_DIR "/test_opcode.ch8";
+  }
+
+  if (out_path) {
+    bench.out = fopen(out_path, "w");
+    if (bench.out == NULL) {
+      perror("Erro ao criar o arquivo de saída");
+      return -1;
+    }
+  }
+
+  CpuArena arena;
+  if (!arena_init(&arena, 1)) {
+    return -1;
+  }
+  set_quirks(arena_get(&arena, 0), (uint8_t)quirks);
+  if (bench.check_jit && !JIT_AVAILABLE) {
+    fprintf(stderr, "Erro: JIT indisponível nesta plataforma.\n");
+    arena_free(&arena);
+    free(roms);
+    return -1;
+  }
+  bool jit = bench.use_jit && JIT_AVAILABLE;
+  fprintf(bench.out,
+          "{\n  \"engine\": \"%s\",\n  \"quirks\": \"%s\",\n"
+          "  \"results\": [",
+          bench.check_jit ? "jit_check" : jit ? "jit" : "interpreter",
+          quirks_name((uint8_t)quirks));
+  run_opcode_benches(&bench, &arena);
+  for (int r = 0; r < rom_count; r++) {
+    run_rom_bench(&bench, &arena, roms[r]);
+  }
+  if (!bench.check_jit) {
+    run_render_bench(&bench, false);
+    run_render_bench(&bench, true);
+    run_scroll_bench(&bench);
+    for (int f = 0; f < UPSCALE_COUNT; f++) {
+      run_upscale_bench(&bench, f);
+    }
+  }
+  fprintf(bench.out, "\n  ]\n}\n");
+
+  arena_free(&arena);
+  free(roms);
+  if (out_path) {
+    fclose(bench.out);
+  }
+  return bench.failures ? 1 : 0;
+}
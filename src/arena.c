@@ -0,0 +1,70 @@
+#include "arena.h"
+#include "jit.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+void *cache_aligned_alloc(size_t size) {
+  // aligned_alloc exige tamanho múltiplo do alinhamento
+  size = (size + CACHE_LINE_SIZE - 1) & ~(size_t)(CACHE_LINE_SIZE - 1);
+#ifdef _WIN32
+  return _aligned_malloc(size, CACHE_LINE_SIZE);
+#else
+  return aligned_alloc(CACHE_LINE_SIZE, size);
+#endif
+}
+
+void cache_aligned_free(void *block) {
+#ifdef _WIN32
+  _aligned_free(block);
+#else
+  free(block);
+#endif
+}
+
+bool arena_init(CpuArena *arena, size_t count) {
+  arena->chips = NULL;
+  arena->count = 0;
+  if (count == 0) {
+    return true;
+  }
+  // sizeof(CPU) já é múltiplo da linha de cache por causa do _Alignas
+  arena->chips = (CPU *)cache_aligned_alloc(count * sizeof(CPU));
+  if (arena->chips == NULL) {
+    fprintf(stderr, "Erro: Falha ao alocar %zu instâncias.\n", count);
+    return false;
+  }
+  arena->count = count;
+  for (size_t n = 0; n < count; n++) {
+    initCPU(&arena->chips[n]);
+  }
+  return true;
+}
+
+void arena_free(CpuArena *arena) {
+  for (size_t n = 0; n < arena->count; n++) {
+    jit_destroy(arena->chips[n].jit);
+  }
+  cache_aligned_free(arena->chips);
+  arena->chips = NULL;
+  arena->count = 0;
+}
+
+// Volta a instância ao estado de power-on. A configuração é mantida: um JIT
+// já criado só tem o cache de código descartado e o perfil de quirks fica.
+void arena_reset(CpuArena *arena, size_t index) {
+  CPU *chip = &arena->chips[index];
+  struct Jit *jit = chip->jit;
+  uint8_t quirks = chip->quirks;
+  initCPU(chip);
+  chip->jit = jit;
+  if (quirks != QUIRKS_LEGACY) {
+    set_quirks(chip, quirks);
+  } else if (jit) {
+    jit_flush(jit);
+  }
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "cpu.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Muitas instâncias em um único bloco contíguo alinhado à linha de cache.
+// Como a memória do convidado vive dentro de cada CPU, criar ou reiniciar
+// uma instância não aloca nada.
+typedef struct {
+  CPU *chips;
+  size_t count;
+} CpuArena;
+
+void *cache_aligned_alloc(size_t size);
+void cache_aligned_free(void *block);
+
+bool arena_init(CpuArena *arena, size_t count);
+void arena_free(CpuArena *arena);
+void arena_reset(CpuArena *arena, size_t index);
+
+static inline CPU *arena_get(CpuArena *arena, size_t index) {
+  return &arena->chips[index];
+}
@@ -0,0 +1,153 @@
+#include "audio.h"
+#include "sched.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+void init_audio(Audio *audio, const CPU *chip) {
+
+  if (audio->initialized) {
+    return;
+  }
+
+  spsc_init(&audio->edges, audio->edge_storage, AUDIO_EDGE_CAPACITY,
+            sizeof(AudioEdge));
+  audio->frequency = chip->frequency > 0 ? chip->frequency : 440;
+  audio->tone_on = false;
+  audio->sent_pattern = false;
+  audio->sent_pitch = DEFAULT_PITCH;
+  memset(audio->sent_samples, 0, sizeof(audio->sent_samples));
+  audio->use_pattern = false;
+  audio->pattern_step = 0;
+  audio->sample_clock = 0;
+  audio->offset = 0;
+  audio->synced = false;
+  audio->playing = false;
+  audio->phase = 0;
+
+  SDL_AudioSpec audio_spec;
+  SDL_zero(audio_spec);
+  audio_spec.freq = AUDIO_SAMPLE_RATE;
+  audio_spec.format = AUDIO_S16SYS;
+  audio_spec.channels = 1;
+  audio_spec.samples = AUDIO_DEVICE_SAMPLES;
+  audio_spec.callback = audio_callback;
+  audio_spec.userdata = audio;
+  audio->device = SDL_OpenAudioDevice(NULL, 0, &audio_spec, NULL, 0);
+  if (audio->device == 0) {
+    fprintf(stderr, "Erro ao inicializar áudio: %s\n", SDL_GetError());
+    exit(1);
+  }
+
+  SDL_PauseAudioDevice(audio->device, 0);
+  audio->initialized = true;
+}
+
+void audio_update(Audio *audio, const CPU *chip, uint32_t cycles_per_frame) {
+  bool on = chip->sound_timer > 0;
+  // Um padrão novo (F002) ou outra altura (FX3A) também geram uma borda
+  bool same_pattern =
+      chip->has_pattern == audio->sent_pattern &&
+      (!chip->has_pattern ||
+       (chip->pitch == audio->sent_pitch &&
+        memcmp(chip->audio_pattern, audio->sent_samples,
+               sizeof(audio->sent_samples)) == 0));
+  if (on == audio->tone_on && same_pattern) {
+    return;
+  }
+
+  AudioEdge edge;
+  edge.time = chip->cycles * AUDIO_SAMPLE_RATE /
+              ((uint64_t)TIMER_HZ * cycles_per_frame);
+  edge.on = on;
+  edge.has_pattern = chip->has_pattern;
+  edge.pitch = chip->pitch;
+  memcpy(edge.pattern, chip->audio_pattern, sizeof(edge.pattern));
+  // Fila cheia: a borda é reenviada no próximo frame, sem bloquear
+  if (spsc_push(&audio->edges, &edge)) {
+    audio->tone_on = on;
+    audio->sent_pattern = chip->has_pattern;
+    audio->sent_pitch = chip->pitch;
+    memcpy(audio->sent_samples, chip->audio_pattern,
+           sizeof(audio->sent_samples));
+  }
+}
+
+// XO-CHIP: o padrão de 128 bits toca a 4000 * 2^((pitch - 64) / 48) bits/s
+static void apply_edge(Audio *audio, const AudioEdge *edge) {
+  audio->playing = edge->on;
+  audio->use_pattern = edge->has_pattern;
+  if (edge->has_pattern) {
+    memcpy(audio->pattern, edge->pattern, sizeof(audio->pattern));
+    double rate = 4000.0 * pow(2.0, (edge->pitch - 64) / 48.0);
+    audio->pattern_step = (uint32_t)(rate * 65536.0 / AUDIO_SAMPLE_RATE);
+  }
+}
+
+static void render_samples(Audio *audio, int16_t *output, int count) {
+  if (!audio->playing) {
+    memset(output, 0, count * sizeof(int16_t));
+    return;
+  }
+  if (audio->use_pattern) {
+    for (int i = 0; i < count; i++) {
+      uint32_t bit = (audio->phase >> 16) & (AUDIO_PATTERN_SIZE * 8 - 1);
+      output[i] = (audio->pattern[bit >> 3] >> (7 - (bit & 7))) & 1
+                      ? AUDIO_VOLUME
+                      : -AUDIO_VOLUME;
+      audio->phase += audio->pattern_step;
+    }
+    return;
+  }
+  uint32_t half_period = AUDIO_SAMPLE_RATE / (2 * audio->frequency);
+  if (half_period == 0) {
+    half_period = 1;
+  }
+  for (int i = 0; i < count; i++) {
+    output[i] = (audio->phase / half_period) & 1 ? AUDIO_VOLUME : -AUDIO_VOLUME;
+    audio->phase++;
+  }
+}
+
+void audio_callback(void *userdata, uint8_t *stream, int len) {
+  Audio *audio = (Audio *)userdata;
+  int16_t *output = (int16_t *)stream;
+  int samples = len / sizeof(int16_t);
+
+  int done = 0;
+  while (done < samples) {
+    int64_t now = (int64_t)(audio->sample_clock + done);
+    int until = samples;
+
+    AudioEdge edge;
+    if (spsc_peek(&audio->edges, &edge)) {
+      int64_t at = (int64_t)edge.time + audio->offset;
+      // Primeira borda, borda atrasada (emulação travou) ou adiantada demais
+      // (modo turbo): realinha o tempo do convidado com o do dispositivo.
+      if (!audio->synced || at < now || at > now + AUDIO_MAX_LEAD) {
+        audio->offset = now + AUDIO_LATENCY_SAMPLES - (int64_t)edge.time;
+        audio->synced = true;
+        at = now + AUDIO_LATENCY_SAMPLES;
+      }
+      if (at <= now) {
+        apply_edge(audio, &edge);
+        spsc_pop(&audio->edges, &edge);
+        continue;
+      }
+      if (at - now < until - done) {
+        until = done + (int)(at - now);
+      }
+    }
+
+    render_samples(audio, output + done, until - done);
+    done = until;
+  }
+  audio->sample_clock += samples;
+}
+
+void shutdown_audio(Audio *audio) {
+  if (audio->initialized) {
+    SDL_CloseAudioDevice(audio->device);
+    audio->initialized = false;
+  }
+}
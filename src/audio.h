@@ -0,0 +1,55 @@
+#pragma once
+
+#include "cpu.h"
+#include "spsc.h"
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define AUDIO_DEVICE_SAMPLES 512
+#define AUDIO_EDGE_CAPACITY 256                 // Potência de 2
+#define AUDIO_LATENCY_SAMPLES (2 * AUDIO_DEVICE_SAMPLES)
+#define AUDIO_MAX_LEAD (AUDIO_SAMPLE_RATE / 4) // Além disso, ressincroniza
+
+// Liga/desliga do som, com o instante em amostras do tempo do convidado.
+// Também carrega o padrão de áudio do XO-CHIP vigente a partir dali.
+typedef struct {
+  uint64_t time;
+  uint8_t on;
+  uint8_t has_pattern;
+  uint8_t pitch;
+  uint8_t pattern[AUDIO_PATTERN_SIZE];
+} AudioEdge;
+
+// Um único dispositivo aberto durante toda a execução. A thread de emulação
+// só empilha bordas na fila; o callback do SDL gera a onda quadrada a partir
+// delas. Nenhum campo é compartilhado fora da fila.
+typedef struct {
+  SDL_AudioDeviceID device;
+  bool initialized;
+  int frequency;
+
+  SpscRing edges;
+  AudioEdge edge_storage[AUDIO_EDGE_CAPACITY];
+
+  // Lado da emulação
+  bool tone_on;
+  bool sent_pattern;
+  uint8_t sent_pitch;
+  uint8_t sent_samples[AUDIO_PATTERN_SIZE];
+
+  // Lado do callback
+  uint64_t sample_clock; // Amostras já geradas
+  int64_t offset;        // Tempo do convidado -> tempo do dispositivo
+  bool synced;
+  bool playing;
+  uint32_t phase;
+  bool use_pattern;
+  uint8_t pattern[AUDIO_PATTERN_SIZE];
+  uint32_t pattern_step; // Posição no padrão por amostra (16.16)
+} Audio;
+
+void init_audio(Audio *audio, const CPU *chip);
+void audio_update(Audio *audio, const CPU *chip, uint32_t cycles_per_frame);
+void audio_callback(void *userdata, uint8_t *stream, int len);
+void shutdown_audio(Audio *audio);
@@ -0,0 +1,124 @@
+#include "chip8.h"
+#include "arena.h"
+#include "cpu.h"
+#include "jit.h"
+#include "sched.h"
+#include <string.h>
+
+_Static_assert(CHIP8_SCREEN_WIDTH == HIRES_WIDTH, "largura da tela");
+_Static_assert(CHIP8_SCREEN_HEIGHT == HIRES_HEIGHT, "altura da tela");
+_Static_assert(CHIP8_SCREEN_PLANES == SCREEN_PLANES, "planos da tela");
+_Static_assert(CHIP8_KEYS == KEYS, "número de teclas");
+_Static_assert((int)CHIP8_QUIRKS_XOCHIP == (int)QUIRKS_XOCHIP,
+               "perfis de quirks");
+_Static_assert(CHIP8_MAX_ROM_SIZE == MEMORY_SIZE - ROM_START_ADDRESS,
+               "tamanho máximo da ROM");
+
+// A CPU vem primeiro para herdar o alinhamento à linha de cache
+struct Chip8Instance {
+  CPU cpu;
+  Scheduler sched;
+  uint32_t seed;
+  size_t rom_size;
+  uint8_t rom[CHIP8_MAX_ROM_SIZE];
+};
+
+Chip8 *chip8_create(void) {
+  Chip8 *chip = (Chip8 *)cache_aligned_alloc(sizeof(Chip8));
+  if (chip == NULL) {
+    return NULL;
+  }
+  initCPU(&chip->cpu);
+  initScheduler(&chip->sched);
+  chip->sched.turbo = true; // O ritmo é de quem chama
+  chip->seed = DEFAULT_RNG_SEED;
+  chip->rom_size = 0;
+  return chip;
+}
+
+void chip8_destroy(Chip8 *chip) {
+  if (chip) {
+    jit_destroy(chip->cpu.jit);
+    cache_aligned_free(chip);
+  }
+}
+
+void chip8_reset(Chip8 *chip) {
+  struct Jit *jit = chip->cpu.jit;
+  uint8_t quirks = chip->cpu.quirks;
+  initCPU(&chip->cpu);
+  chip->cpu.jit = jit;
+  set_quirks(&chip->cpu, quirks);
+  seedCPU(&chip->cpu, chip->seed);
+  // Também descarta o cache do JIT
+  initROMData(&chip->cpu, chip->rom, chip->rom_size);
+}
+
+bool chip8_load_rom(Chip8 *chip, const uint8_t *rom, size_t size) {
+  if (size > CHIP8_MAX_ROM_SIZE) {
+    return false;
+  }
+  memcpy(chip->rom, rom, size);
+  chip->rom_size = size;
+  chip8_reset(chip);
+  return true;
+}
+
+void chip8_set_seed(Chip8 *chip, uint32_t seed) {
+  chip->seed = seed;
+  seedCPU(&chip->cpu, seed);
+}
+
+void chip8_set_cycles_per_frame(Chip8 *chip, uint32_t cycles) {
+  if (cycles > 0) {
+    chip->sched.cycles_per_frame = cycles;
+  }
+}
+
+bool chip8_set_quirks(Chip8 *chip, int quirks) {
+  if (quirks < 0 || quirks >= QUIRKS_COUNT) {
+    return false;
+  }
+  set_quirks(&chip->cpu, (uint8_t)quirks);
+  return true;
+}
+
+bool chip8_enable_jit(Chip8 *chip, bool enable) {
+  if (enable && chip->cpu.jit == NULL) {
+    chip->cpu.jit = jit_create();
+  } else if (!enable && chip->cpu.jit) {
+    jit_destroy(chip->cpu.jit);
+    chip->cpu.jit = NULL;
+  }
+  return chip->cpu.jit != NULL;
+}
+
+uint64_t chip8_run_cycles(Chip8 *chip, uint64_t n) {
+  return run_cycles(&chip->cpu, &chip->sched, n);
+}
+
+void chip8_run_frame(Chip8 *chip) { run_frame(&chip->cpu, &chip->sched); }
+
+void chip8_set_key(Chip8 *chip, uint8_t key, bool down) {
+  if (key < KEYS) {
+    chip->cpu.keys[key] = down;
+  }
+}
+
+const uint64_t *chip8_framebuffer(const Chip8 *chip) {
+  return &chip->cpu.screen.rows[0][0][0];
+}
+
+bool chip8_hires(const Chip8 *chip) { return chip->cpu.screen.hires; }
+
+bool chip8_take_redraw(Chip8 *chip) {
+  bool redraw = chip->cpu.draw_flag;
+  chip->cpu.draw_flag = false;
+  return redraw;
+}
+
+bool chip8_sound_active(const Chip8 *chip) {
+  return chip->cpu.sound_timer > 0;
+}
+
+uint64_t chip8_cycles(const Chip8 *chip) { return chip->cpu.cycles; }
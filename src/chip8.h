@@ -0,0 +1,75 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// API pública da libchip8: o núcleo do emulador sem SDL, para embutir muitas
+// instâncias em um mesmo processo. Cada instância é independente (memória,
+// gerador aleatório, JIT) e pode rodar em qualquer thread, desde que uma
+// instância não seja usada por duas threads ao mesmo tempo.
+//
+//   Chip8 *chip = chip8_create();
+//   chip8_load_rom(chip, rom, rom_size);
+//   for (;;) {
+//     chip8_set_key(chip, 0x5, true);
+//     chip8_run_frame(chip);
+//     const uint64_t *rows = chip8_framebuffer(chip);
+//     ...
+//   }
+//   chip8_destroy(chip);
+
+#define CHIP8_SCREEN_WIDTH 128 // Alta resolução; em baixa só 64x32 é usado
+#define CHIP8_SCREEN_HEIGHT 64
+#define CHIP8_SCREEN_PLANES 2
+#define CHIP8_KEYS 16
+#ifdef XOCHIP_MEMORY
+#define CHIP8_MAX_ROM_SIZE (65536 - 0x200)
+#else
+#define CHIP8_MAX_ROM_SIZE (4096 - 0x200)
+#endif
+
+// Perfis de compatibilidade
+enum {
+  CHIP8_QUIRKS_LEGACY = 0,
+  CHIP8_QUIRKS_VIP,
+  CHIP8_QUIRKS_CHIP48,
+  CHIP8_QUIRKS_SCHIP,
+  CHIP8_QUIRKS_XOCHIP,
+};
+
+typedef struct Chip8Instance Chip8;
+
+Chip8 *chip8_create(void);
+void chip8_destroy(Chip8 *chip);
+
+// Volta ao power-on e recarrega a última ROM carregada
+void chip8_reset(Chip8 *chip);
+// Copia a ROM (até CHIP8_MAX_ROM_SIZE bytes) e reinicia a instância
+bool chip8_load_rom(Chip8 *chip, const uint8_t *rom, size_t size);
+
+void chip8_set_seed(Chip8 *chip, uint32_t seed);
+void chip8_set_cycles_per_frame(Chip8 *chip, uint32_t cycles);
+// Escolhe o interpretador especializado do perfil; mantido por chip8_reset
+bool chip8_set_quirks(Chip8 *chip, int quirks);
+bool chip8_enable_jit(Chip8 *chip, bool enable);
+
+// Executa exatamente n instruções; os timers decrementam a cada
+// cycles_per_frame instruções do tempo do convidado
+uint64_t chip8_run_cycles(Chip8 *chip, uint64_t n);
+// Executa até a próxima fronteira de frame (60 Hz do convidado)
+void chip8_run_frame(Chip8 *chip);
+
+void chip8_set_key(Chip8 *chip, uint8_t key, bool down);
+
+// Tela sem cópia: CHIP8_SCREEN_PLANES planos de CHIP8_SCREEN_HEIGHT linhas,
+// cada linha com duas palavras (bit 63 da primeira = x 0, da segunda = x 64).
+// Em baixa resolução só a primeira palavra das 32 primeiras linhas é usada.
+// O ponteiro é válido enquanto a instância existir; o conteúdo muda a cada
+// execução.
+const uint64_t *chip8_framebuffer(const Chip8 *chip);
+// true em 128x64 (SUPER-CHIP/XO-CHIP), false em 64x32
+bool chip8_hires(const Chip8 *chip);
+// true se a tela mudou desde a última chamada
+bool chip8_take_redraw(Chip8 *chip);
+bool chip8_sound_active(const Chip8 *chip);
+uint64_t chip8_cycles(const Chip8 *chip);
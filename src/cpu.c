@@ -1,8 +1,9 @@
 #include "cpu.h"
 #include "dram.h"
+#include "emu.h"
 #include "files.h"
-#include "render.h"
-#include <SDL2/SDL.h>
+#include "jit.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -10,20 +11,32 @@ void initCPU(CPU *chip) {
   chip->pc = 0x200;
   chip->i = 0;
   chip->sp = 0;
+  chip->delay_timer = 0;
+  chip->cycles = 0;
+  chip->rng_state = DEFAULT_RNG_SEED;
+  chip->jit = NULL;
+  chip->trace = NULL;
+  chip->profile = NULL;
+  chip->quirks = QUIRKS_LEGACY;
+  chip->interp = interpreter_for(QUIRKS_LEGACY);
 
-  chip->dram = initDRAM();
-  if (chip->dram == NULL) {
-    fprintf(stderr, "Erro: Falha ao inicializar a DRAM.\n");
-    exit(EXIT_FAILURE);
-  }
+  resetDRAM(&chip->dram);
 
   chip->sound_timer = 10;
-  chip->audio_playing = false;
+  chip->frequency = 440;
 
   memset(chip->v, 0, sizeof(chip->v));
   memset(chip->stack, 0, sizeof(chip->stack));
-  memset(chip->screen, 0, sizeof(chip->screen));
+  memset(&chip->screen, 0, sizeof(chip->screen));
+  chip->draw_flag = true;
+  chip->planes = 1;
+  memset(chip->rpl, 0, sizeof(chip->rpl));
+  memset(chip->audio_pattern, 0, sizeof(chip->audio_pattern));
+  chip->pitch = DEFAULT_PITCH;
+  chip->has_pattern = false;
   memset(chip->keys, 0, sizeof(chip->keys));
+  chip->fault = FAULT_NONE;
+  chip->fault_pc = 0;
 
   const uint8_t fontset[80] = {
       0xF0, 0x90, 0x90, 0x90, 0xF0, 0x20, 0x60, 0x20, 0x20, 0x70, 0xF0, 0x10,
@@ -34,16 +47,114 @@ void initCPU(CPU *chip) {
       0xF0, 0x80, 0x80, 0x80, 0xF0, 0xE0, 0x90, 0x90, 0x90, 0xE0, 0xF0, 0x80,
       0xF0, 0x80, 0xF0, 0xF0, 0x80, 0xF0, 0x80, 0x80};
 
-  memcpy(&chip->dram->memory[0x50], fontset, sizeof(fontset));
-  init_audio(chip);
+  // Dígitos grandes 0-F (8x10) do SUPER-CHIP/XO-CHIP, logo após os pequenos
+  const uint8_t big_fontset[160] = {
+      0x3C, 0x7E, 0xE7, 0xC3, 0xC3, 0xC3, 0xC3, 0xE7, 0x7E, 0x3C, // 0
+      0x18, 0x38, 0x58, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, // 1
+      0x3E, 0x7F, 0xC3, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xFF, 0xFF, // 2
+      0x3C, 0x7E, 0xC3, 0x03, 0x0E, 0x0E, 0x03, 0xC3, 0x7E, 0x3C, // 3
+      0x06, 0x0E, 0x1E, 0x36, 0x66, 0xC6, 0xFF, 0xFF, 0x06, 0x06, // 4
+      0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFE, 0x03, 0xC3, 0x7E, 0x3C, // 5
+      0x3E, 0x7C, 0xC0, 0xC0, 0xFC, 0xFE, 0xC3, 0xC3, 0x7E, 0x3C, // 6
+      0xFF, 0xFF, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x60, 0x60, // 7
+      0x3C, 0x7E, 0xC3, 0xC3, 0x7E, 0x7E, 0xC3, 0xC3, 0x7E, 0x3C, // 8
+      0x3C, 0x7E, 0xC3, 0xC3, 0x7F, 0x3F, 0x03, 0x03, 0x3E, 0x7C, // 9
+      0x18, 0x3C, 0x66, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, // A
+      0xFC, 0xFE, 0xC3, 0xC3, 0xFE, 0xFE, 0xC3, 0xC3, 0xFE, 0xFC, // B
+      0x3C, 0x7E, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0x7E, 0x3C, // C
+      0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, // D
+      0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFC, 0xC0, 0xC0, 0xFF, 0xFF, // E
+      0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFC, 0xC0, 0xC0, 0xC0, 0xC0, // F
+  };
+
+  memcpy(&chip->dram.memory[FONT_ADDRESS], fontset, sizeof(fontset));
+  memcpy(&chip->dram.memory[BIG_FONT_ADDRESS], big_fontset,
+         sizeof(big_fontset));
+  flush_decode(chip);
 }
 
 void initROM(CPU *chip, FILEDRAM *file) {
-  if (file->size > (MEMORY_SIZE - ROM_START_ADDRESS)) {
-    printf("Erro: A ROM é muito grande para a memória do Chip-8.\n");
+  if (!initROMData(chip, file->buffer, (size_t)file->size)) {
     exit(-1);
   }
+}
+
+// Copia a ROM direto de um buffer (ex.: um pacote mapeado com mmap)
+bool initROMData(CPU *chip, const uint8_t *data, size_t size) {
+  if (size > (MEMORY_SIZE - ROM_START_ADDRESS)) {
+    printf("Erro: A ROM é muito grande para a memória do Chip-8.\n");
+    return false;
+  }
+
+  memcpy(&chip->dram.memory[ROM_START_ADDRESS], data, size);
+  flush_decode(chip);
+  return true;
+}
+
+void seedCPU(CPU *chip, uint32_t seed) {
+  // Estado zero travaria o xorshift
+  chip->rng_state = seed ? seed : DEFAULT_RNG_SEED;
+}
+
+// Escolhe o perfil uma vez: o interpretador já vem especializado e o cache
+// de decodificação é refeito, porque a decodificação depende do perfil
+void set_quirks(CPU *chip, uint8_t quirks) {
+  chip->quirks = quirks < QUIRKS_COUNT ? quirks : QUIRKS_LEGACY;
+  chip->interp = interpreter_for(chip->quirks);
+  flush_decode(chip);
+}
 
-  // memcpy(&chip->dram->memory[ROM_START_ADDRESS], program, rom_size);
-  memcpy(&chip->dram->memory[ROM_START_ADDRESS], file->buffer, file->size);
+// FNV-1a de 64 bits aplicado a cada palavra visível de um plano
+static uint64_t hash_plane(const Screen *screen, int plane, uint64_t hash,
+                           uint64_t *used) {
+  int height = screen_height(screen);
+  int words = screen->hires ? ROW_WORDS : 1;
+  for (int y = 0; y < height; y++) {
+    for (int w = 0; w < words; w++) {
+      hash ^= screen->rows[plane][y][w];
+      hash *= 0x100000001B3ull;
+      *used |= screen->rows[plane][y][w];
+    }
+  }
+  return hash;
+}
+
+uint64_t screen_hash(const CPU *chip) {
+  // Em baixa resolução com um só plano é o mesmo hash de quando a tela
+  // tinha uma palavra por linha; o segundo plano só entra se tiver algo
+  // desenhado.
+  uint64_t used = 0;
+  uint64_t hash = hash_plane(&chip->screen, 0, 0xCBF29CE484222325ull, &used);
+  used = 0;
+  uint64_t with_plane = hash_plane(&chip->screen, 1, hash, &used);
+  return used ? with_plane : hash;
+}
+
+const char *fault_name(uint8_t fault) {
+  static const char *names[FAULT_COUNT] = {
+      [FAULT_NONE] = "nenhuma",
+      [FAULT_STACK_OVERFLOW] = "stack-overflow",
+      [FAULT_STACK_UNDERFLOW] = "stack-underflow",
+      [FAULT_SPRITE_RANGE] = "sprite-range",
+      [FAULT_STORE_RANGE] = "store-range",
+      [FAULT_UNKNOWN_OPCODE] = "unknown-opcode",
+  };
+  return fault < FAULT_COUNT ? names[fault] : "?";
+}
+
+void invalidate_decode(CPU *chip, uint16_t addr, uint16_t len) {
+  // A instrução que começa em addr - 1 também contém o byte escrito
+  for (int n = -1; n < (int)len; n++) {
+    chip->decode_cache[dram_addr(addr + n)].handler = OP_UNDECODED;
+  }
+  if (chip->jit) {
+    jit_invalidate(chip->jit, addr, len);
+  }
+}
+
+void flush_decode(CPU *chip) {
+  memset(chip->decode_cache, 0, sizeof(chip->decode_cache));
+  if (chip->jit) {
+    jit_flush(chip->jit);
+  }
 }
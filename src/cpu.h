@@ -1,36 +1,99 @@
 #pragma once
+#include "decode.h"
 #include "dram.h"
 #include "files.h"
+#include "screen.h"
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
-#define MEM_SIZE 4096
-#define SCREEN_WIDTH 64
-#define SCREEN_HEIGHT 32
+#define MEM_SIZE DRAM_SIZE
 #define NUM_REGISTERS 16
 #define STACK_SIZE 16
 #define KEYS 16
-#define MEMORY_SIZE 4096
+#define MEMORY_SIZE DRAM_SIZE
 #define ROM_START_ADDRESS 0x200
+#define FONT_ADDRESS 0x50
+#define BIG_FONT_ADDRESS 0xA0 // Dígitos 8x10 do SUPER-CHIP (FX30)
+#define AUDIO_PATTERN_SIZE 16 // 128 amostras de 1 bit (XO-CHIP)
+#define DEFAULT_PITCH 64      // 4000 amostras/s
 #define AUDIO_BUFFER_SIZE 4096
 #define AUDIO_SAMPLE_RATE 44100
 #define AUDIO_VOLUME 3000
+#define DEFAULT_RNG_SEED 0x2545F491u
+#define CACHE_LINE_SIZE 64
 
+// Erros do programa convidado. Só o primeiro é registrado (com o PC da
+// instrução); a execução continua bem definida e o fuzzer (tools/fuzz.c)
+// usa o registro para encontrar entradas que levam até eles.
+enum {
+  FAULT_NONE = 0,
+  FAULT_STACK_OVERFLOW,  // 2NNN com a pilha cheia: a CPU para no CALL
+  FAULT_STACK_UNDERFLOW, // 00EE com a pilha vazia: a CPU para no RET
+  FAULT_SPRITE_RANGE,    // DXYN lendo o sprite além do fim da memória
+  FAULT_STORE_RANGE,     // FX20/FX33/FX55/5XY2 gravando além do fim
+  FAULT_UNKNOWN_OPCODE,
+  FAULT_COUNT
+};
+
+// Alinhada à linha de cache: registradores ficam juntos no início e um
+// vetor de instâncias (ver arena.h) não compartilha linhas entre elas.
 struct Chip8 {
-  struct DRAM *dram;
-  uint8_t v[NUM_REGISTERS];
+  _Alignas(CACHE_LINE_SIZE) uint8_t v[NUM_REGISTERS];
   uint16_t i;
   uint16_t pc;
   uint16_t stack[STACK_SIZE];
   uint8_t sp;
   uint8_t delay_timer;
   uint8_t sound_timer;
-  uint8_t screen[SCREEN_WIDTH * SCREEN_HEIGHT];
+  bool draw_flag; // A tela mudou desde o último frame
   uint8_t keys[KEYS];
+  uint64_t cycles;    // Instruções executadas (tempo do convidado)
+  uint32_t rng_state; // Gerador do CXNN, independente por instância
+
+  struct Jit *jit; // Recompilador opcional (NULL = interpretador)
+  struct Trace *trace; // Trace binário opcional (ver trace.h)
+  struct Profile *profile; // Profiler opcional (ver profile.h)
+  uint8_t quirks;  // Perfil de compatibilidade (QUIRKS_*)
+  const struct Interpreter *interp; // Interpretador especializado do perfil
+
+  Screen screen;
+  uint8_t planes;              // Planos afetados por DXYN/00E0/rolagem (FN01)
+  uint8_t rpl[NUM_REGISTERS];  // Flags do usuário (FX75/FX85)
+  uint8_t audio_pattern[AUDIO_PATTERN_SIZE]; // F002
+  uint8_t pitch;                             // FX3A
+  bool has_pattern; // Som toca o padrão em vez da onda quadrada
+  uint8_t fault;    // FAULT_*
+  uint16_t fault_pc;
+
+  _Alignas(CACHE_LINE_SIZE) struct DRAM dram;
+
+  // Cache de decodificação: uma entrada por endereço da memória
+  DecodedOp decode_cache[MEMORY_SIZE];
 
-  bool audio_playing;
   int frequency;
 };
 typedef struct Chip8 CPU;
 void initCPU(CPU *chip);
 void initROM(CPU *chip, FILEDRAM *file);
+bool initROMData(CPU *chip, const uint8_t *data, size_t size);
+void seedCPU(CPU *chip, uint32_t seed);
+void set_quirks(CPU *chip, uint8_t quirks);
+uint64_t screen_hash(const CPU *chip);
+const char *fault_name(uint8_t fault);
+void invalidate_decode(CPU *chip, uint16_t addr, uint16_t len);
+void flush_decode(CPU *chip);
+
+static inline uint8_t screen_pixel(const CPU *chip, int x, int y) {
+  return screen_pixel_at(&chip->screen, x, y);
+}
+
+// xorshift32: cada instância tem seu próprio estado, sem o rand() global
+static inline uint8_t random_byte(CPU *chip) {
+  uint32_t x = chip->rng_state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  chip->rng_state = x;
+  return (uint8_t)(x >> 24);
+}
@@ -0,0 +1,357 @@
+#include "decode.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+// FXNN dos perfis VIP, CHIP-48, SUPER-CHIP e XO-CHIP: qualquer X
+static uint8_t decode_standard_f(uint16_t opcode, uint8_t quirks) {
+  if (QUIRK_XO(quirks)) {
+    if (opcode == 0xF000)
+      return OP_LD_LONG;
+    if (opcode == 0xF002)
+      return OP_AUDIO;
+    if ((opcode & 0x00FF) == 0x01)
+      return OP_PLANE;
+    if ((opcode & 0x00FF) == 0x3A)
+      return OP_PITCH;
+  }
+  if (QUIRK_HIRES(quirks)) {
+    switch (opcode & 0x00FF) {
+    case 0x30:
+      return OP_LD_HF;
+    case 0x75:
+      return OP_ST_RPL;
+    case 0x85:
+      return OP_LD_RPL;
+    }
+  }
+  switch (opcode & 0x00FF) {
+  case 0x07:
+    return OP_LD_VX_DT;
+  case 0x0A:
+    return OP_LD_K;
+  case 0x15:
+    return OP_LD_DT;
+  case 0x18:
+    return OP_LD_ST;
+  case 0x1E:
+    return OP_ADD_I;
+  case 0x29:
+    return OP_LD_F;
+  case 0x33:
+    return OP_BCD;
+  case 0x55:
+    return OP_ST_REGS;
+  case 0x65:
+    return OP_LD_REGS;
+  }
+  return OP_UNKNOWN;
+}
+
+static uint8_t decode_handler(uint16_t opcode, uint8_t quirks) {
+  bool standard = QUIRK_STANDARD_DECODE(quirks);
+  switch (opcode & 0xF000) {
+  case 0x0000:
+    if ((opcode & 0x00FF) == 0xE0)
+      return OP_CLS;
+    if ((opcode & 0x00FF) == 0xEE)
+      return OP_RET;
+    if (QUIRK_HIRES(quirks)) {
+      if ((opcode & 0xFFF0) == 0x00C0)
+        return OP_SCD;
+      switch (opcode) {
+      case 0x00FB:
+        return OP_SCR;
+      case 0x00FC:
+        return OP_SCL;
+      case 0x00FD:
+        return OP_EXIT;
+      case 0x00FE:
+        return OP_LOW;
+      case 0x00FF:
+        return OP_HIGH;
+      }
+    }
+    if (QUIRK_XO(quirks) && (opcode & 0xFFF0) == 0x00D0)
+      return OP_SCU;
+    return OP_NOP;
+  case 0x1000:
+    return OP_JP;
+  case 0x2000:
+    return OP_CALL;
+  case 0x3000:
+    return OP_SE_IMM;
+  case 0x4000:
+    return OP_SNE_IMM;
+  case 0x5000:
+    if (QUIRK_XO(quirks) && (opcode & 0x000F) == 0x2)
+      return OP_ST_RANGE;
+    if (QUIRK_XO(quirks) && (opcode & 0x000F) == 0x3)
+      return OP_LD_RANGE;
+    return OP_SE_REG;
+  case 0x6000:
+    return OP_LD_IMM;
+  case 0x7000:
+    return OP_ADD_IMM;
+  case 0x8000:
+    switch (opcode & 0x000F) {
+    case 0x0:
+      return OP_LD_REG;
+    case 0x1:
+      return OP_OR;
+    case 0x2:
+      return OP_AND;
+    case 0x3:
+      return OP_XOR;
+    case 0x4:
+      return OP_ADD_REG;
+    case 0x5:
+      return OP_SUB;
+    case 0x6:
+      return OP_SHR;
+    case 0x7:
+      return OP_SUBN;
+    case 0xE:
+      return OP_SHL;
+    }
+    return OP_UNKNOWN;
+  case 0x9000:
+    if (standard) {
+      return (opcode & 0x000F) == 0 ? OP_SNE_REG : OP_UNKNOWN;
+    }
+    return (opcode & 0x00FF) == 0x90 ? OP_SKIP_XOR : OP_NOP;
+  case 0xA000:
+    return OP_LD_I;
+  case 0xB000:
+    return OP_JP_V0;
+  case 0xC000:
+    return OP_RND;
+  case 0xD000:
+    return OP_DRW;
+  case 0xE000:
+    switch (opcode & 0x00FF) {
+    case 0x9E:
+      return OP_SKP;
+    case 0xA1:
+      return OP_SKNP;
+    }
+    return OP_UNKNOWN;
+  case 0xF000:
+    if (standard) {
+      return decode_standard_f(opcode, quirks);
+    }
+    // Algumas variações só são reconhecidas para um X específico
+    switch (opcode & 0x00FF) {
+    case 0x07:
+      return OP_LD_VX_DT;
+    case 0x0A:
+      return opcode == 0xF20A ? OP_LD_K : OP_NOP;
+    case 0x15:
+      return OP_LD_DT;
+    case 0x18:
+      return opcode == 0xF018 ? OP_LD_ST : OP_NOP;
+    case 0x1E:
+      return OP_ADD_I;
+    case 0x20:
+      return OP_ST_VX;
+    case 0x29:
+      if (opcode == 0xF129)
+        return OP_LD_F;
+      return opcode == 0xF229 ? OP_LD_HF : OP_NOP;
+    case 0x33:
+      return opcode == 0xFE33 ? OP_BCD : OP_NOP;
+    case 0x55:
+      return OP_ST_REGS;
+    case 0x65:
+      return OP_LD_REGS;
+    case 0x90:
+      return OP_NOT;
+    }
+    return OP_UNKNOWN;
+  }
+  return OP_UNKNOWN;
+}
+
+DecodedOp decode_op(uint16_t opcode, uint8_t quirks) {
+  DecodedOp op;
+  op.handler = decode_handler(opcode, quirks);
+  op.x = (opcode & 0x0F00) >> 8;
+  op.y = (opcode & 0x00F0) >> 4;
+  op.n = opcode & 0x000F;
+  op.nn = opcode & 0x00FF;
+  op.nnn = opcode & 0x0FFF;
+  return op;
+}
+
+void disassemble(uint16_t opcode, uint8_t quirks, char *out, size_t size) {
+  DecodedOp op = decode_op(opcode, quirks);
+  switch (op.handler) {
+  case OP_NOP:
+    snprintf(out, size, "NOP");
+    break;
+  case OP_CLS:
+    snprintf(out, size, "CLS");
+    break;
+  case OP_RET:
+    snprintf(out, size, "RET");
+    break;
+  case OP_JP:
+    snprintf(out, size, "JP 0x%03X", op.nnn);
+    break;
+  case OP_CALL:
+    snprintf(out, size, "CALL 0x%03X", op.nnn);
+    break;
+  case OP_SE_IMM:
+    snprintf(out, size, "SE V%X, 0x%02X", op.x, op.nn);
+    break;
+  case OP_SNE_IMM:
+    snprintf(out, size, "SNE V%X, 0x%02X", op.x, op.nn);
+    break;
+  case OP_SE_REG:
+    snprintf(out, size, "SE V%X, V%X", op.x, op.y);
+    break;
+  case OP_LD_IMM:
+    snprintf(out, size, "LD V%X, 0x%02X", op.x, op.nn);
+    break;
+  case OP_ADD_IMM:
+    snprintf(out, size, "ADD V%X, 0x%02X", op.x, op.nn);
+    break;
+  case OP_LD_REG:
+    snprintf(out, size, "LD V%X, V%X", op.x, op.y);
+    break;
+  case OP_OR:
+    snprintf(out, size, "OR V%X, V%X", op.x, op.y);
+    break;
+  case OP_AND:
+    snprintf(out, size, "AND V%X, V%X", op.x, op.y);
+    break;
+  case OP_XOR:
+    snprintf(out, size, "XOR V%X, V%X", op.x, op.y);
+    break;
+  case OP_ADD_REG:
+    snprintf(out, size, "ADD V%X, V%X", op.x, op.y);
+    break;
+  case OP_SUB:
+    snprintf(out, size, "SUB V%X, V%X", op.x, op.y);
+    break;
+  case OP_SHR:
+    snprintf(out, size, "SHR V%X, V%X", op.x, op.y);
+    break;
+  case OP_SUBN:
+    snprintf(out, size, "SUBN V%X, V%X", op.x, op.y);
+    break;
+  case OP_SHL:
+    snprintf(out, size, "SHL V%X, V%X", op.x, op.y);
+    break;
+  case OP_SKIP_XOR:
+    snprintf(out, size, "SKXOR V0, V1");
+    break;
+  case OP_SNE_REG:
+    snprintf(out, size, "SNE V%X, V%X", op.x, op.y);
+    break;
+  case OP_LD_I:
+    snprintf(out, size, "LD I, 0x%03X", op.nnn);
+    break;
+  case OP_JP_V0:
+    if (QUIRK_JUMP_VX(quirks)) {
+      snprintf(out, size, "JP V%X, 0x%03X", op.x, op.nnn);
+    } else {
+      snprintf(out, size, "JP V0, 0x%03X", op.nnn);
+    }
+    break;
+  case OP_RND:
+    snprintf(out, size, "RND V%X, 0x%02X", op.x, op.nn);
+    break;
+  case OP_DRW:
+    snprintf(out, size, "DRW V%X, V%X, %u", op.x, op.y, op.n);
+    break;
+  case OP_SKP:
+    snprintf(out, size, "SKP V%X", op.x);
+    break;
+  case OP_SKNP:
+    snprintf(out, size, "SKNP V%X", op.x);
+    break;
+  case OP_LD_VX_DT:
+    snprintf(out, size, "LD V%X, DT", op.x);
+    break;
+  case OP_LD_K:
+    snprintf(out, size, "LD V%X, K", op.x);
+    break;
+  case OP_LD_DT:
+    snprintf(out, size, "LD DT, V%X", op.x);
+    break;
+  case OP_LD_ST:
+    snprintf(out, size, "LD ST, V%X", op.x);
+    break;
+  case OP_ADD_I:
+    snprintf(out, size, "ADD I, V%X", op.x);
+    break;
+  case OP_ST_VX:
+    snprintf(out, size, "LD [I+%X], V%X", op.x, op.x);
+    break;
+  case OP_LD_F:
+    snprintf(out, size, "LD F, V%X", op.x);
+    break;
+  case OP_LD_HF:
+    snprintf(out, size, "LD HF, V%X", op.x);
+    break;
+  case OP_BCD:
+    snprintf(out, size, "LD B, V%X", op.x);
+    break;
+  case OP_ST_REGS:
+    snprintf(out, size, "LD [I], V%X", op.x);
+    break;
+  case OP_LD_REGS:
+    snprintf(out, size, "LD V%X, [I]", op.x);
+    break;
+  case OP_NOT:
+    snprintf(out, size, "NOT V%X", op.x);
+    break;
+  case OP_SCD:
+    snprintf(out, size, "SCD %u", op.n);
+    break;
+  case OP_SCR:
+    snprintf(out, size, "SCR");
+    break;
+  case OP_SCL:
+    snprintf(out, size, "SCL");
+    break;
+  case OP_EXIT:
+    snprintf(out, size, "EXIT");
+    break;
+  case OP_LOW:
+    snprintf(out, size, "LOW");
+    break;
+  case OP_HIGH:
+    snprintf(out, size, "HIGH");
+    break;
+  case OP_ST_RPL:
+    snprintf(out, size, "LD R, V%X", op.x);
+    break;
+  case OP_LD_RPL:
+    snprintf(out, size, "LD V%X, R", op.x);
+    break;
+  case OP_SCU:
+    snprintf(out, size, "SCU %u", op.n);
+    break;
+  case OP_ST_RANGE:
+    snprintf(out, size, "LD [I], V%X-V%X", op.x, op.y);
+    break;
+  case OP_LD_RANGE:
+    snprintf(out, size, "LD V%X-V%X, [I]", op.x, op.y);
+    break;
+  case OP_LD_LONG:
+    snprintf(out, size, "LD I, LONG"); // NNNN vem na palavra seguinte
+    break;
+  case OP_PLANE:
+    snprintf(out, size, "PLANE %u", op.x);
+    break;
+  case OP_AUDIO:
+    snprintf(out, size, "AUDIO");
+    break;
+  case OP_PITCH:
+    snprintf(out, size, "PITCH V%X", op.x);
+    break;
+  default:
+    snprintf(out, size, "DW 0x%04X", opcode);
+  }
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "quirks.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Índices dos handlers do interpretador. OP_UNDECODED (0) marca uma entrada
+// do cache que ainda não foi decodificada ou que foi invalidada.
+enum {
+  OP_UNDECODED = 0,
+  OP_NOP,      // 0NNN e variações ignoradas
+  OP_CLS,      // 00E0
+  OP_RET,      // 00EE
+  OP_JP,       // 1NNN
+  OP_CALL,     // 2NNN
+  OP_SE_IMM,   // 3XNN
+  OP_SNE_IMM,  // 4XNN
+  OP_SE_REG,   // 5XY0
+  OP_LD_IMM,   // 6XNN
+  OP_ADD_IMM,  // 7XNN
+  OP_LD_REG,   // 8XY0
+  OP_OR,       // 8XY1
+  OP_AND,      // 8XY2
+  OP_XOR,      // 8XY3
+  OP_ADD_REG,  // 8XY4
+  OP_SUB,      // 8XY5
+  OP_SHR,      // 8XY6
+  OP_SUBN,     // 8XY7
+  OP_SHL,      // 8XYE
+  OP_SKIP_XOR, // 9090
+  OP_SNE_REG,  // 9XY0 (decodificação padrão)
+  OP_LD_I,     // ANNN
+  OP_JP_V0,    // BNNN
+  OP_RND,      // CXNN
+  OP_DRW,      // DXYN
+  OP_SKP,      // EX9E
+  OP_SKNP,     // EXA1
+  OP_LD_VX_DT, // FX07
+  OP_LD_K,     // F20A
+  OP_LD_DT,    // FX15
+  OP_LD_ST,    // F018
+  OP_ADD_I,    // FX1E
+  OP_ST_VX,    // FX20
+  OP_LD_F,     // F129
+  OP_LD_HF,    // F229 (FX30 no SUPER-CHIP)
+  OP_BCD,      // FE33
+  OP_ST_REGS,  // FX55
+  OP_LD_REGS,  // FX65
+  OP_NOT,      // FX90
+  OP_SCD,      // 00CN (SUPER-CHIP)
+  OP_SCR,      // 00FB
+  OP_SCL,      // 00FC
+  OP_EXIT,     // 00FD
+  OP_LOW,      // 00FE
+  OP_HIGH,     // 00FF
+  OP_ST_RPL,   // FX75
+  OP_LD_RPL,   // FX85
+  OP_SCU,      // 00DN (XO-CHIP)
+  OP_ST_RANGE, // 5XY2
+  OP_LD_RANGE, // 5XY3
+  OP_LD_LONG,  // F000 NNNN
+  OP_PLANE,    // FN01
+  OP_AUDIO,    // F002
+  OP_PITCH,    // FX3A
+  OP_UNKNOWN,
+  OP_COUNT
+};
+
+// Instrução pré-decodificada: handler mais os campos já extraídos do opcode.
+typedef struct {
+  uint8_t handler;
+  uint8_t x;
+  uint8_t y;
+  uint8_t n;
+  uint8_t nn;
+  uint16_t nnn;
+} DecodedOp;
+
+DecodedOp decode_op(uint16_t opcode, uint8_t quirks);
+// Mnemônico no estilo do Cowgod (ex.: "LD V3, 0x2A") como o perfil decodifica
+void disassemble(uint16_t opcode, uint8_t quirks, char *out, size_t size);
@@ -0,0 +1,109 @@
+#include "delta.h"
+#include <string.h>
+
+// Linha em bytes, na ordem plano, palavra, byte mais significativo primeiro
+static void row_bytes(const Screen *screen, int y, uint8_t *out) {
+  for (int p = 0; p < SCREEN_PLANES; p++) {
+    for (int w = 0; w < ROW_WORDS; w++) {
+      uint64_t word = screen->rows[p][y][w];
+      for (int b = 0; b < 8; b++) {
+        *out++ = (uint8_t)(word >> (56 - 8 * b));
+      }
+    }
+  }
+}
+
+static size_t encode_row(const uint8_t *diff, uint8_t *out) {
+  size_t size = 0;
+  int n = 0;
+  while (n < DELTA_ROW_BYTES) {
+    int run = 0;
+    while (n + run < DELTA_ROW_BYTES && diff[n + run] == 0) {
+      run++;
+    }
+    if (run >= 2 || (run == 1 && n + 1 == DELTA_ROW_BYTES)) {
+      out[size++] = (uint8_t)(0x80 | (run - 1));
+      n += run;
+      continue;
+    }
+    // Literais até a próxima sequência de dois ou mais zeros
+    int start = n;
+    while (n < DELTA_ROW_BYTES &&
+           (diff[n] != 0 ||
+            (n + 1 < DELTA_ROW_BYTES && diff[n + 1] != 0))) {
+      n++;
+    }
+    out[size++] = (uint8_t)(n - start - 1);
+    memcpy(&out[size], &diff[start], (size_t)(n - start));
+    size += (size_t)(n - start);
+  }
+  return size;
+}
+
+size_t delta_encode(const Screen *base, const Screen *screen, uint8_t *out) {
+  size_t size = 0;
+  for (int y = 0; y < HIRES_HEIGHT; y++) {
+    bool changed = false;
+    for (int p = 0; p < SCREEN_PLANES; p++) {
+      for (int w = 0; w < ROW_WORDS; w++) {
+        changed |= base->rows[p][y][w] != screen->rows[p][y][w];
+      }
+    }
+    if (!changed) {
+      continue;
+    }
+    uint8_t before[DELTA_ROW_BYTES];
+    uint8_t after[DELTA_ROW_BYTES];
+    row_bytes(base, y, before);
+    row_bytes(screen, y, after);
+    for (int b = 0; b < DELTA_ROW_BYTES; b++) {
+      after[b] ^= before[b];
+    }
+    out[size++] = (uint8_t)y;
+    size += encode_row(after, &out[size]);
+  }
+  return size;
+}
+
+bool delta_apply(Screen *screen, const uint8_t *data, size_t size) {
+  size_t pos = 0;
+  while (pos < size) {
+    int y = data[pos++];
+    if (y >= HIRES_HEIGHT) {
+      return false;
+    }
+    uint8_t diff[DELTA_ROW_BYTES];
+    int n = 0;
+    while (n < DELTA_ROW_BYTES) {
+      if (pos >= size) {
+        return false;
+      }
+      uint8_t control = data[pos++];
+      int count = (control & 0x7F) + 1;
+      if (n + count > DELTA_ROW_BYTES) {
+        return false;
+      }
+      if (control & 0x80) {
+        memset(&diff[n], 0, (size_t)count);
+      } else {
+        if (pos + (size_t)count > size) {
+          return false;
+        }
+        memcpy(&diff[n], &data[pos], (size_t)count);
+        pos += (size_t)count;
+      }
+      n += count;
+    }
+    const uint8_t *byte = diff;
+    for (int p = 0; p < SCREEN_PLANES; p++) {
+      for (int w = 0; w < ROW_WORDS; w++) {
+        uint64_t word = 0;
+        for (int b = 0; b < 8; b++) {
+          word = (word << 8) | *byte++;
+        }
+        screen->rows[p][y][w] ^= word;
+      }
+    }
+  }
+  return true;
+}
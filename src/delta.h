@@ -0,0 +1,25 @@
+#pragma once
+#include "screen.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Bytes de uma linha da tela: os dois planos, duas palavras cada, com o
+// pixel x 0 no bit mais alto do primeiro byte
+#define DELTA_ROW_BYTES (SCREEN_PLANES * ROW_WORDS * 8)
+// Pior caso de uma linha codificada: o y, os bytes literais e um controle a
+// cada dois bytes (zeros isolados entram como literais)
+#define DELTA_ROW_MAX (1 + DELTA_ROW_BYTES + DELTA_ROW_BYTES / 2)
+#define DELTA_MAX_SIZE (HIRES_HEIGHT * DELTA_ROW_MAX)
+
+// Diferença entre duas telas, só das linhas que mudaram. Cada linha é o y
+// seguido do XOR dos seus DELTA_ROW_BYTES bytes com a linha da base, em RLE
+// de zeros: um controle c com o bit 7 ligado é uma sequência de
+// (c & 0x7F) + 1 zeros; sem ele, vêm c + 1 bytes literais. Uma linha igual
+// à base não ocupa nada, então telas iguais dão 0 bytes.
+//
+// Grava em out (pelo menos DELTA_MAX_SIZE bytes) e retorna o tamanho.
+size_t delta_encode(const Screen *base, const Screen *screen, uint8_t *out);
+// Aplica a diferença sobre screen (que deve ser a base usada na codificação).
+// false se os dados estiverem malformados; hires não faz parte da diferença.
+bool delta_apply(Screen *screen, const uint8_t *data, size_t size);
@@ -7,11 +7,24 @@
 
 #ifdef _DRAM__
 
+// XO-CHIP endereça 64 KB (F000 NNNN); como isso multiplica o estado de cada
+// instância (memória, cache de decodificação, JIT), fica atrás da opção
+// XOCHIP_MEMORY do CMake
+#ifdef XOCHIP_MEMORY
+#define DRAM_SIZE 65536
+#else
+#define DRAM_SIZE 4096
+#endif
+#define DRAM_MASK (DRAM_SIZE - 1)
+
+// Espaço de endereçamento embutido no estado da CPU
 struct DRAM {
-  uint8_t *memory;
+  uint8_t memory[DRAM_SIZE];
 };
 
-struct DRAM *initDRAM();
-void freeDRAM(struct DRAM *dram);
+// Endereços sempre dão a volta no fim da memória, sem desvio
+static inline uint16_t dram_addr(uint32_t addr) { return addr & DRAM_MASK; }
+
+void resetDRAM(struct DRAM *dram);
 
 #endif
@@ -0,0 +1,621 @@
+#include "emu.h"
+#include "profile.h"
+#include "trace.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Cada perfil de quirks gera uma cópia das funções abaixo com o perfil
+// constante; só funciona se elas forem de fato expandidas no chamador.
+#if defined(_MSC_VER)
+#define ALWAYS_INLINE static __forceinline
+#define NOINLINE static __declspec(noinline)
+#define UNLIKELY(x) (x)
+#else
+#define ALWAYS_INLINE static inline __attribute__((always_inline))
+#define NOINLINE static __attribute__((noinline))
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+#endif
+
+ALWAYS_INLINE const DecodedOp *fetch_op(struct Chip8 *chip,
+                                        const uint8_t quirks) {
+  uint16_t addr = dram_addr(chip->pc);
+  DecodedOp *op = &chip->decode_cache[addr];
+  if (op->handler == OP_UNDECODED) {
+    *op = decode_op((chip->dram.memory[addr] << 8) |
+                        chip->dram.memory[dram_addr(addr + 1)],
+                    quirks);
+  }
+  return op;
+}
+
+// Resultado e VF de 8XY4..8XYE. O perfil legado grava VF primeiro (com X = F
+// o resultado prevalece); os demais gravam VF por último, como o hardware.
+// SUB, SHR, SUBN e SHL do perfil legado ficam com o código original, que
+// lê VX de novo depois de gravar VF.
+ALWAYS_INLINE void set_with_flag(struct Chip8 *chip, uint8_t x, uint8_t value,
+                                 uint8_t flag, const uint8_t quirks) {
+  if (QUIRK_FLAG_LAST(quirks)) {
+    chip->v[x] = value;
+    chip->v[0xF] = flag;
+  } else {
+    chip->v[0xF] = flag;
+    chip->v[x] = value;
+  }
+}
+
+// Só a primeira falha fica registrada. O PC já aponta para a instrução
+// seguinte.
+static inline void raise_fault(struct Chip8 *chip, uint8_t fault) {
+  if (chip->fault == FAULT_NONE) {
+    chip->fault = fault;
+    chip->fault_pc = dram_addr(chip->pc - 2);
+  }
+}
+
+// Acesso de len bytes a partir de I que dá a volta no fim da memória
+static inline void check_range(struct Chip8 *chip, uint32_t len,
+                               uint8_t fault) {
+  if (chip->i + len > MEMORY_SIZE) {
+    raise_fault(chip, fault);
+  }
+}
+
+// Salta a próxima instrução. No XO-CHIP a F000 NNNN ocupa 4 bytes e é
+// saltada inteira.
+ALWAYS_INLINE void skip_next(struct Chip8 *chip, const uint8_t quirks) {
+  if (QUIRK_XO(quirks) && chip->dram.memory[dram_addr(chip->pc)] == 0xF0 &&
+      chip->dram.memory[dram_addr(chip->pc + 1)] == 0x00) {
+    chip->pc += 4;
+  } else {
+    chip->pc += 2;
+  }
+}
+
+// DXYN: cada linha do sprite é alinhada ao bit 63 e deslocada até x; em alta
+// resolução o que passa da primeira palavra vai para a segunda. Os perfis
+// sem alta resolução compilam só o caminho de 64x32 original.
+ALWAYS_INLINE void draw_sprite(struct Chip8 *chip, const DecodedOp *op,
+                               const uint8_t quirks) {
+  bool hires = QUIRK_HIRES(quirks) && chip->screen.hires;
+  bool big = QUIRK_HIRES(quirks) && op->n == 0; // DXY0: 16x16
+  int width = hires ? HIRES_WIDTH : SCREEN_WIDTH;
+  int height = hires ? HIRES_HEIGHT : SCREEN_HEIGHT;
+  int rows = big ? 16 : op->n;
+  int x = chip->v[op->x] & (width - 1);
+  int y = chip->v[op->y] & (height - 1);
+  uint8_t planes = QUIRK_XO(quirks) ? chip->planes : 1;
+  uint16_t addr = chip->i;
+  uint64_t collision = 0;
+  check_range(chip, (big ? 32 : rows) * ((planes & 1) + (planes >> 1)),
+              FAULT_SPRITE_RANGE);
+
+  for (int p = 0; p < SCREEN_PLANES; p++) {
+    if (!(planes & (1 << p))) {
+      continue;
+    }
+    for (int row = 0; row < rows; ++row) {
+      int sy = y + row;
+      if (sy >= height) {
+        if (!QUIRK_XO(quirks)) {
+          break; // Cortado na borda de baixo
+        }
+        sy -= height;
+      }
+      uint64_t bits;
+      if (big) {
+        bits = (uint64_t)((chip->dram.memory[dram_addr(addr + 2 * row)] << 8) |
+                          chip->dram.memory[dram_addr(addr + 2 * row + 1)])
+               << 48;
+      } else {
+        bits = (uint64_t)chip->dram.memory[dram_addr(addr + row)] << 56;
+      }
+      uint64_t *line = chip->screen.rows[p][sy];
+      if (!hires) {
+        uint64_t l0 = bits >> x;
+        if (QUIRK_XO(quirks) && x > 0) {
+          l0 |= bits << (64 - x); // Dá a volta na borda direita
+        }
+        collision |= line[0] & l0;
+        line[0] ^= l0;
+      } else {
+        uint64_t l0, l1;
+        if (x < 64) {
+          l0 = bits >> x;
+          l1 = x > 0 ? bits << (64 - x) : 0;
+        } else {
+          l0 = QUIRK_XO(quirks) && x > 64 ? bits << (128 - x) : 0;
+          l1 = bits >> (x - 64);
+        }
+        collision |= (line[0] & l0) | (line[1] & l1);
+        line[0] ^= l0;
+        line[1] ^= l1;
+      }
+    }
+    addr += big ? 32 : rows;
+  }
+  chip->v[0xF] = collision != 0;
+  chip->draw_flag = true;
+}
+
+// Executa uma instrução já decodificada; o PC já aponta para a seguinte.
+ALWAYS_INLINE void execute(struct Chip8 *chip, const DecodedOp *op,
+                           const uint8_t quirks) {
+  switch (op->handler) {
+
+  case OP_NOP:
+    // 0NNN e variações não implementadas (ignoradas)
+    break;
+
+  case OP_CLS:
+    // Clear screen (só os planos selecionados no XO-CHIP)
+    screen_clear(&chip->screen, QUIRK_XO(quirks) ? chip->planes : 1);
+    chip->draw_flag = true;
+    break;
+
+  case OP_RET:
+    if (chip->sp == 0) {
+      raise_fault(chip, FAULT_STACK_UNDERFLOW);
+      chip->pc -= 2;
+      break;
+    }
+    chip->pc = chip->stack[--chip->sp]; // Return from subroutine
+    break;
+
+  case OP_JP:
+    // 1NNN: Jump to address NNN
+    chip->pc = op->nnn;
+    break;
+
+  case OP_CALL:
+    // 2NNN: Call subroutine at NNN
+    if (chip->sp >= STACK_SIZE) {
+      raise_fault(chip, FAULT_STACK_OVERFLOW);
+      chip->pc -= 2;
+      break;
+    }
+    chip->stack[chip->sp++] = chip->pc;
+    chip->pc = op->nnn;
+    break;
+
+  case OP_SE_IMM:
+    // 3XNN: Skip next instruction if VX == NN
+    if (chip->v[op->x] == op->nn) {
+      skip_next(chip, quirks);
+    }
+    break;
+
+  case OP_SNE_IMM:
+    // 4XNN: Skip next instruction if VX != NN
+    if (chip->v[op->x] != op->nn) {
+      skip_next(chip, quirks);
+    }
+    break;
+
+  case OP_SE_REG:
+    // 5XY0: Skip next instruction if VX == VY
+    if (chip->v[op->x] == chip->v[op->y]) {
+      skip_next(chip, quirks);
+    }
+    break;
+
+  case OP_LD_IMM:
+    // 6XNN: Set VX = NN
+    chip->v[op->x] = op->nn;
+    break;
+
+  case OP_ADD_IMM:
+    // 7XNN: Add NN to VX (no carry)
+    chip->v[op->x] += op->nn;
+    break;
+
+  case OP_LD_REG:
+    // 8XY0: Set VX = VY
+    chip->v[op->x] = chip->v[op->y];
+    break;
+
+  case OP_OR:
+    // 8XY1: Set VX = VX | VY
+    chip->v[op->x] |= chip->v[op->y];
+    if (QUIRK_LOGIC_VF(quirks)) {
+      chip->v[0xF] = 0;
+    }
+    break;
+
+  case OP_AND:
+    // 8XY2: Set VX = VX & VY
+    chip->v[op->x] &= chip->v[op->y];
+    if (QUIRK_LOGIC_VF(quirks)) {
+      chip->v[0xF] = 0;
+    }
+    break;
+
+  case OP_XOR:
+    // 8XY3: Set VX = VX ^ VY
+    chip->v[op->x] ^= chip->v[op->y];
+    if (QUIRK_LOGIC_VF(quirks)) {
+      chip->v[0xF] = 0;
+    }
+    break;
+
+  case OP_ADD_REG: {
+    // 8XY4: Add VY to VX. VF = 1 on carry, 0 otherwise
+    uint16_t sum = chip->v[op->x] + chip->v[op->y];
+    set_with_flag(chip, op->x, sum & 0xFF, sum > 0xFF, quirks);
+    break;
+  }
+
+  case OP_SUB:
+    // 8XY5: Subtract VY from VX. VF = 0 on borrow, 1 otherwise
+    if (QUIRK_FLAG_LAST(quirks)) {
+      set_with_flag(chip, op->x, chip->v[op->x] - chip->v[op->y],
+                    chip->v[op->x] > chip->v[op->y], quirks);
+    } else {
+      chip->v[0xF] = chip->v[op->x] > chip->v[op->y];
+      chip->v[op->x] -= chip->v[op->y];
+    }
+    break;
+
+  case OP_SHR:
+    // 8XY6: Shift right by 1. VF = least significant bit
+    if (QUIRK_FLAG_LAST(quirks)) {
+      uint8_t value = chip->v[QUIRK_SHIFT_VY(quirks) ? op->y : op->x];
+      set_with_flag(chip, op->x, value >> 1, value & 0x1, quirks);
+    } else {
+      chip->v[0xF] = chip->v[op->x] & 0x1;
+      chip->v[op->x] >>= 1;
+    }
+    break;
+
+  case OP_SUBN:
+    // 8XY7: Set VX = VY - VX. VF = 0 on borrow, 1 otherwise
+    if (QUIRK_FLAG_LAST(quirks)) {
+      set_with_flag(chip, op->x, chip->v[op->y] - chip->v[op->x],
+                    chip->v[op->y] > chip->v[op->x], quirks);
+    } else {
+      chip->v[0xF] = chip->v[op->y] > chip->v[op->x];
+      chip->v[op->x] = chip->v[op->y] - chip->v[op->x];
+    }
+    break;
+
+  case OP_SHL:
+    // 8XYE: Shift left by 1. VF = most significant bit
+    if (QUIRK_FLAG_LAST(quirks)) {
+      uint8_t value = chip->v[QUIRK_SHIFT_VY(quirks) ? op->y : op->x];
+      set_with_flag(chip, op->x, value << 1, value >> 7, quirks);
+    } else {
+      chip->v[0xF] = chip->v[op->x] >> 7;
+      chip->v[op->x] <<= 1;
+    }
+    break;
+
+  case OP_SKIP_XOR: {
+    // 9090: Condicional XOR entre V0 e V1; salta se resultado for 0
+    uint8_t result = chip->v[0] ^ chip->v[1];
+    if (result == 0) {
+      chip->pc += 2; // Salta próxima instrução
+    }
+    break;
+  }
+
+  case OP_SNE_REG:
+    // 9XY0: Skip next instruction if VX != VY
+    if (chip->v[op->x] != chip->v[op->y]) {
+      skip_next(chip, quirks);
+    }
+    break;
+
+  case OP_LD_I:
+    // ANNN: Set I = NNN
+    chip->i = op->nnn;
+    break;
+
+  case OP_JP_V0:
+    // BNNN: Jump to address NNN + V0 (BXNN: XNN + VX)
+    chip->pc = op->nnn + chip->v[QUIRK_JUMP_VX(quirks) ? op->x : 0];
+    break;
+
+  case OP_RND:
+    // CXNN: Set VX = random byte AND NN
+    chip->v[op->x] = random_byte(chip) & op->nn;
+    break;
+
+  case OP_DRW:
+    // DXYN: Draw sprite at (VX, VY) with N bytes of sprite data starting at I
+    // A posição inicial dá a volta na tela; o sprite é cortado nas bordas
+    // (no XO-CHIP também dá a volta).
+    draw_sprite(chip, op, quirks);
+    break;
+
+  case OP_SKP:
+    // EX9E: Skip next instruction if key VX is pressed
+    if (chip->keys[chip->v[op->x] & 0xF]) {
+      skip_next(chip, quirks);
+    }
+    break;
+
+  case OP_SKNP:
+    // EXA1: Skip next instruction if key VX is not pressed
+    if (!chip->keys[chip->v[op->x] & 0xF]) {
+      skip_next(chip, quirks);
+    }
+    break;
+
+  case OP_LD_VX_DT:
+    // FX07: Set VX = delay timer
+    chip->v[op->x] = chip->delay_timer;
+    break;
+
+  case OP_LD_K: {
+    // F20A: Espera por entrada de teclado e armazena o valor em VX
+    bool key_pressed = false;
+
+    for (int i = 0; i < 16; i++) {
+      if (chip->keys[i]) {
+        chip->v[op->x] = i; // Armazena a tecla pressionada em VX
+        key_pressed = true;
+        break;
+      }
+    }
+
+    // Continua aguardando se nenhuma tecla foi pressionada
+    if (!key_pressed) {
+      chip->pc -= 2; // Reexecuta a instrução no próximo ciclo
+    }
+    break;
+  }
+
+  case OP_LD_DT:
+    // FX15: Set delay timer = VX
+    chip->delay_timer = chip->v[op->x];
+    break;
+
+  case OP_LD_ST:
+    // F018: Set sound timer to VX
+    chip->sound_timer = chip->v[op->x];
+    break;
+
+  case OP_ADD_I:
+    // FX1E: Add VX to I
+    chip->i += chip->v[op->x];
+    break;
+
+  case OP_ST_VX:
+    // Fx20: Armazena VX na memória em I + X
+    check_range(chip, op->x + 1, FAULT_STORE_RANGE);
+    chip->dram.memory[dram_addr(chip->i + op->x)] = chip->v[op->x];
+    invalidate_decode(chip, chip->i + op->x, 1);
+    break;
+
+  case OP_LD_F:
+    // F129: Set I to the sprite address for the hexadecimal digit in VX
+    if (QUIRK_STANDARD_DECODE(quirks)) {
+      chip->i = FONT_ADDRESS + (chip->v[op->x] & 0xF) * 5;
+    } else {
+      chip->i = chip->v[op->x] * 5; // Cada sprite ocupa 5 bytes
+    }
+    break;
+
+  case OP_LD_HF:
+    // F229 (variação) / FX30: Configurar I para os dígitos grandes
+    if (QUIRK_HIRES(quirks)) {
+      chip->i = BIG_FONT_ADDRESS + (chip->v[op->x] & 0xF) * 10;
+    } else {
+      chip->i = chip->v[op->x] * 10; // Cada sprite ocupa 10 bytes
+    }
+    break;
+
+  case OP_BCD: {
+    // FE33: Store BCD representation of VX in memory at I
+    uint8_t value = chip->v[op->x];
+    check_range(chip, 3, FAULT_STORE_RANGE);
+    chip->dram.memory[dram_addr(chip->i)] = value / 100;           // Centenas
+    chip->dram.memory[dram_addr(chip->i + 1)] = (value / 10) % 10; // Dezenas
+    chip->dram.memory[dram_addr(chip->i + 2)] = value % 10;        // Unidades
+    invalidate_decode(chip, chip->i, 3);
+    break;
+  }
+
+  case OP_ST_REGS:
+    // Fx55: Armazena os registradores V0 até VX na memória começando em I
+    check_range(chip, op->x + 1, FAULT_STORE_RANGE);
+    for (int i = 0; i <= op->x; i++) {
+      chip->dram.memory[dram_addr(chip->i + i)] = chip->v[i];
+    }
+    invalidate_decode(chip, chip->i, op->x + 1);
+    chip->i += QUIRK_I_STEP(quirks, op->x);
+    break;
+
+  case OP_LD_REGS:
+    // Fx65: Carrega os valores da memória em I para os registradores V0 até
+    // VX
+    for (int i = 0; i <= op->x; i++) {
+      chip->v[i] = chip->dram.memory[dram_addr(chip->i + i)];
+    }
+    chip->i += QUIRK_I_STEP(quirks, op->x);
+    break;
+
+  case OP_NOT:
+    // Fx90: Inverte os bits do valor em VX
+    chip->v[op->x] ^= 0xFF;
+    break;
+
+  case OP_SCD:
+    // 00CN: Rola a tela N linhas para baixo
+    screen_scroll_down(&chip->screen, QUIRK_XO(quirks) ? chip->planes : 1,
+                       op->n);
+    chip->draw_flag = true;
+    break;
+
+  case OP_SCU:
+    // 00DN: Rola a tela N linhas para cima
+    screen_scroll_up(&chip->screen, chip->planes, op->n);
+    chip->draw_flag = true;
+    break;
+
+  case OP_SCR:
+    // 00FB: Rola a tela 4 pixels para a direita
+    screen_scroll_right(&chip->screen, QUIRK_XO(quirks) ? chip->planes : 1);
+    chip->draw_flag = true;
+    break;
+
+  case OP_SCL:
+    // 00FC: Rola a tela 4 pixels para a esquerda
+    screen_scroll_left(&chip->screen, QUIRK_XO(quirks) ? chip->planes : 1);
+    chip->draw_flag = true;
+    break;
+
+  case OP_EXIT:
+    // 00FD: Encerra o programa (fica parado nesta instrução)
+    chip->pc -= 2;
+    break;
+
+  case OP_LOW:
+  case OP_HIGH:
+    // 00FE/00FF: Baixa (64x32) ou alta (128x64) resolução
+    screen_set_hires(&chip->screen, op->handler == OP_HIGH);
+    chip->draw_flag = true;
+    break;
+
+  case OP_ST_RPL:
+    // FX75: Salva V0 até VX nas flags do usuário
+    memcpy(chip->rpl, chip->v, op->x + 1);
+    break;
+
+  case OP_LD_RPL:
+    // FX85: Carrega V0 até VX das flags do usuário
+    memcpy(chip->v, chip->rpl, op->x + 1);
+    break;
+
+  case OP_ST_RANGE: {
+    // 5XY2: Armazena VX até VY (em qualquer ordem) em I, sem mudar I
+    int count = abs(op->x - op->y);
+    int dir = op->x <= op->y ? 1 : -1;
+    check_range(chip, count + 1, FAULT_STORE_RANGE);
+    for (int n = 0; n <= count; n++) {
+      chip->dram.memory[dram_addr(chip->i + n)] = chip->v[op->x + n * dir];
+    }
+    invalidate_decode(chip, chip->i, count + 1);
+    break;
+  }
+
+  case OP_LD_RANGE: {
+    // 5XY3: Carrega VX até VY (em qualquer ordem) de I, sem mudar I
+    int count = abs(op->x - op->y);
+    int dir = op->x <= op->y ? 1 : -1;
+    for (int n = 0; n <= count; n++) {
+      chip->v[op->x + n * dir] = chip->dram.memory[dram_addr(chip->i + n)];
+    }
+    break;
+  }
+
+  case OP_LD_LONG:
+    // F000 NNNN: I = NNNN, lido da palavra seguinte
+    chip->i = (chip->dram.memory[dram_addr(chip->pc)] << 8) |
+              chip->dram.memory[dram_addr(chip->pc + 1)];
+    chip->pc += 2;
+    break;
+
+  case OP_PLANE:
+    // FN01: Seleciona os planos de desenho (N = máscara de bits)
+    chip->planes = op->x & 0x3;
+    break;
+
+  case OP_AUDIO:
+    // F002: Carrega o padrão de áudio de 16 bytes em I
+    for (int n = 0; n < AUDIO_PATTERN_SIZE; n++) {
+      chip->audio_pattern[n] = chip->dram.memory[dram_addr(chip->i + n)];
+    }
+    chip->has_pattern = true;
+    break;
+
+  case OP_PITCH:
+    // FX3A: Altura do padrão de áudio = VX
+    chip->pitch = chip->v[op->x];
+    break;
+
+  default:
+    raise_fault(chip, FAULT_UNKNOWN_OPCODE);
+    printf("Opcode desconhecido: 0x%X\n",
+           (chip->dram.memory[dram_addr(chip->pc - 2)] << 8) |
+               chip->dram.memory[dram_addr(chip->pc - 1)]);
+  }
+}
+
+// Fora do laço quente: com o trace desligado o custo por instrução é só o
+// teste do ponteiro em step()
+NOINLINE void traced_execute(struct Chip8 *chip, const DecodedOp *op,
+                             uint16_t pc) {
+  uint8_t before[NUM_REGISTERS];
+  memcpy(before, chip->v, sizeof(before));
+  uint16_t opcode = (chip->dram.memory[dram_addr(pc)] << 8) |
+                    chip->dram.memory[dram_addr(pc + 1)];
+  chip->interp->exec(chip, op);
+  trace_step(chip->trace, chip, pc, opcode, before);
+}
+
+ALWAYS_INLINE void step(struct Chip8 *chip, const uint8_t quirks) {
+  const DecodedOp *op = fetch_op(chip, quirks);
+  uint16_t pc = chip->pc;
+  chip->pc += 2;
+  if (UNLIKELY(chip->trace != NULL)) {
+    traced_execute(chip, op, pc);
+  } else {
+    execute(chip, op, quirks);
+  }
+#ifdef PROFILE_MODE
+  if (chip->profile != NULL) {
+    profile_op(chip->profile, chip, op, pc);
+  }
+#endif
+}
+
+// Um interpretador completo por perfil, sem nenhum teste de quirk em tempo
+// de execução
+#define DEFINE_INTERPRETER(name, quirks)                                      \
+  static void name##_step(struct Chip8 *chip) { step(chip, quirks); }       \
+  static void name##_exec(struct Chip8 *chip, const DecodedOp *op) {        \
+    execute(chip, op, quirks);                                              \
+  }                                                                         \
+  static void name##_run(struct Chip8 *chip, uint64_t count) {              \
+    for (uint64_t n = 0; n < count; n++) {                                  \
+      step(chip, quirks);                                                   \
+    }                                                                       \
+  }                                                                         \
+  static uint64_t name##_cover(struct Chip8 *chip, uint64_t count,          \
+                               uint8_t *edges) {                            \
+    for (uint64_t n = 0; n < count; n++) {                                  \
+      uint16_t from = chip->pc;                                             \
+      step(chip, quirks);                                                   \
+      edges[coverage_edge(from, chip->pc)]++;                               \
+      if (chip->fault != FAULT_NONE) {                                      \
+        return n + 1;                                                       \
+      }                                                                     \
+    }                                                                       \
+    return count;                                                           \
+  }
+
+DEFINE_INTERPRETER(legacy, QUIRKS_LEGACY)
+DEFINE_INTERPRETER(vip, QUIRKS_VIP)
+DEFINE_INTERPRETER(chip48, QUIRKS_CHIP48)
+DEFINE_INTERPRETER(schip, QUIRKS_SCHIP)
+DEFINE_INTERPRETER(xochip, QUIRKS_XOCHIP)
+
+static const struct Interpreter interpreters[QUIRKS_COUNT] = {
+    [QUIRKS_LEGACY] = {legacy_step, legacy_exec, legacy_run, legacy_cover},
+    [QUIRKS_VIP] = {vip_step, vip_exec, vip_run, vip_cover},
+    [QUIRKS_CHIP48] = {chip48_step, chip48_exec, chip48_run, chip48_cover},
+    [QUIRKS_SCHIP] = {schip_step, schip_exec, schip_run, schip_cover},
+    [QUIRKS_XOCHIP] = {xochip_step, xochip_exec, xochip_run, xochip_cover},
+};
+
+const struct Interpreter *interpreter_for(uint8_t quirks) {
+  return &interpreters[quirks < QUIRKS_COUNT ? quirks : QUIRKS_LEGACY];
+}
+
+void emu(struct Chip8 *chip) { chip->interp->step(chip); }
+
+void emu_exec(struct Chip8 *chip, const DecodedOp *op) {
+  chip->interp->exec(chip, op);
+}
@@ -10,7 +10,7 @@ typedef struct {
 } FILEDRAM;
 
 static FILE *openfile(const char *name) {
-  FILE *file = fopen(name, "rb+");
+  FILE *file = fopen(name, "rb");
   if (file == NULL) {
     perror("Error ao abrir o arquivo");
     return NULL;
@@ -49,11 +49,13 @@ static FILEDRAM *initFILE(const char *filename) {
   }
   long size = sizeBin(file);
   uint8_t *buffer = buffercreate(size, file);
+  fclose(file);
   if (buffer == NULL) {
     return NULL;
   }
   file_t = (FILEDRAM *)malloc(sizeof(FILEDRAM));
   if (file_t == NULL) {
+    free(buffer);
     return NULL;
   }
   file_t->name = filename;
@@ -61,3 +63,10 @@ static FILEDRAM *initFILE(const char *filename) {
   file_t->buffer = buffer;
   return file_t;
 }
+
+static void freeFILE(FILEDRAM *file) {
+  if (file) {
+    free(file->buffer);
+    free(file);
+  }
+}
@@ -0,0 +1,43 @@
+#include "framebuffer.h"
+
+static const uint32_t palette[4] = {PIXEL_OFF, PIXEL_ON, PIXEL_PLANE2,
+                                    PIXEL_BOTH};
+
+static inline uint32_t pixel_color(uint64_t plane0, uint64_t plane1,
+                                   int bit) {
+  return palette[((plane0 >> bit) & 1) | (((plane1 >> bit) & 1) << 1)];
+}
+
+void framebuffer_to_argb_native(const Screen *screen, void *pixels,
+                                size_t pitch) {
+  int words = screen_width(screen) / 64;
+  for (int y = 0; y < screen_height(screen); ++y) {
+    uint32_t *line = (uint32_t *)((uint8_t *)pixels + y * pitch);
+    for (int w = 0; w < words; ++w) {
+      uint64_t row0 = screen->rows[0][y][w];
+      uint64_t row1 = screen->rows[1][y][w];
+      for (int x = 0; x < 64; ++x) {
+        line[w * 64 + x] = pixel_color(row0, row1, 63 - x);
+      }
+    }
+  }
+}
+
+void framebuffer_to_argb(const Screen *screen, void *pixels, size_t pitch) {
+  if (screen->hires) {
+    framebuffer_to_argb_native(screen, pixels, pitch);
+    return;
+  }
+
+  for (int y = 0; y < SCREEN_HEIGHT; ++y) {
+    uint32_t *top = (uint32_t *)((uint8_t *)pixels + 2 * y * pitch);
+    uint32_t *bottom = (uint32_t *)((uint8_t *)top + pitch);
+    uint64_t row0 = screen->rows[0][y][0];
+    uint64_t row1 = screen->rows[1][y][0];
+    for (int x = 0; x < SCREEN_WIDTH; ++x) {
+      uint32_t color = pixel_color(row0, row1, SCREEN_WIDTH - 1 - x);
+      top[2 * x] = top[2 * x + 1] = color;
+      bottom[2 * x] = bottom[2 * x + 1] = color;
+    }
+  }
+}
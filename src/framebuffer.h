@@ -0,0 +1,23 @@
+#pragma once
+#include "screen.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define PIXEL_ON 0xFFFFFFFFu     // ARGB, plano 0
+#define PIXEL_OFF 0xFF000000u    // ARGB
+#define PIXEL_PLANE2 0xFF808080u // ARGB, só o plano 1 (XO-CHIP)
+#define PIXEL_BOTH 0xFFC0C0C0u   // ARGB, os dois planos
+
+// A saída tem sempre a resolução alta; em baixa resolução cada pixel vira
+// um bloco 2x2, então a textura não muda de tamanho ao trocar de modo.
+#define FRAMEBUFFER_WIDTH HIRES_WIDTH
+#define FRAMEBUFFER_HEIGHT HIRES_HEIGHT
+
+// Expande a tela de 1 bit por pixel e por plano para ARGB8888. pitch em
+// bytes. Não depende de SDL: o frontend chama com a textura travada e o
+// benchmark com um buffer comum.
+void framebuffer_to_argb(const Screen *screen, void *pixels, size_t pitch);
+// Mesma conversão na resolução atual da tela (64x32 ou 128x64), sem dobrar
+// a baixa resolução; é a entrada dos filtros de upscale.h
+void framebuffer_to_argb_native(const Screen *screen, void *pixels,
+                                size_t pitch);
@@ -0,0 +1,98 @@
+#include "headless.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static double elapsed_seconds(const struct timespec *start,
+                              const struct timespec *end) {
+  return (double)(end->tv_sec - start->tv_sec) +
+         (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void write_state(const CPU *chip, FILE *out) {
+  fprintf(out, "PC: 0x%04X I: 0x%04X SP: %u\n", chip->pc, chip->i, chip->sp);
+  fprintf(out, "DT: %u ST: %u\n", chip->delay_timer, chip->sound_timer);
+  for (int r = 0; r < NUM_REGISTERS; r++) {
+    fprintf(out, "V%X: %02X%c", r, chip->v[r],
+            r == NUM_REGISTERS - 1 ? '\n' : ' ');
+  }
+  fprintf(out, "STACK:");
+  for (int s = 0; s < chip->sp && s < STACK_SIZE; s++) {
+    fprintf(out, " %04X", chip->stack[s]);
+  }
+  fprintf(out, "\n");
+
+  // Um caractere por pixel na resolução atual: '#' = plano 0, 'o' = só o
+  // plano 1 e '@' = os dois (XO-CHIP)
+  static const char pixels[4] = {'.', '#', 'o', '@'};
+  int width = screen_width(&chip->screen);
+  int height = screen_height(&chip->screen);
+  for (int y = 0; y < height; y++) {
+    char line[HIRES_WIDTH + 1];
+    for (int x = 0; x < width; x++) {
+      line[x] = pixels[screen_pixel(chip, x, y)];
+    }
+    line[width] = '\0';
+    fprintf(out, "%s\n", line);
+  }
+}
+
+bool dump_state(const CPU *chip, const char *path) {
+  if (path == NULL || strcmp(path, "-") == 0) {
+    write_state(chip, stdout);
+    return true;
+  }
+
+  FILE *out = fopen(path, "w");
+  if (out == NULL) {
+    perror("Erro ao criar o arquivo de saída");
+    return false;
+  }
+  write_state(chip, out);
+  fclose(out);
+  return true;
+}
+
+int run_headless(CPU *chip, const Scheduler *sched,
+                 const HeadlessConfig *config) {
+  uint64_t budget = config->cycles;
+  if (budget == 0 && config->frames == 0 && config->replay) {
+    // Por padrão reproduz a sessão inteira
+    budget = config->replay->header.end_cycle;
+  }
+  if (budget == 0) {
+    budget = config->frames ? config->frames * sched->cycles_per_frame
+                            : HEADLESS_DEFAULT_CYCLES;
+  }
+
+  // Headless sempre roda em modo turbo: o tempo do convidado avança
+  // apenas pelo número de instruções executadas.
+  struct timespec start, end;
+  timespec_get(&start, TIME_UTC);
+  if (config->replay) {
+    replay_run(config->replay, chip, sched, budget);
+  } else {
+    run_cycles(chip, sched, budget);
+  }
+  timespec_get(&end, TIME_UTC);
+
+  double seconds = elapsed_seconds(&start, &end);
+  double rate = seconds > 0 ? budget / seconds / 1e6 : 0.0;
+  if (sched->idle_skip) {
+    // Parte dos ciclos pode ter avançado sem executar: é tempo do convidado,
+    // não instruções
+    fprintf(stderr,
+            "%llu ciclos do convidado em %.3f s (%.2f M ciclos/s, com o salto "
+            "de laços de espera)\n",
+            (unsigned long long)budget, seconds, rate);
+  } else {
+    fprintf(stderr, "Executadas %llu instruções em %.3f s (%.2f MIPS)\n",
+            (unsigned long long)budget, seconds, rate);
+  }
+  if (chip->fault != FAULT_NONE) {
+    fprintf(stderr, "Falha do programa: %s em 0x%03X\n",
+            fault_name(chip->fault), chip->fault_pc);
+  }
+
+  return dump_state(chip, config->dump_path) ? 0 : -1;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "cpu.h"
+#include "replay.h"
+#include "sched.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HEADLESS_DEFAULT_CYCLES 1000000
+
+// Execução sem SDL: roda a ROM o mais rápido possível até esgotar o
+// orçamento de instruções (ou de frames) e grava o estado final.
+typedef struct {
+  uint64_t cycles;       // Orçamento de instruções (0 = usar frames)
+  uint64_t frames;       // Orçamento de frames (0 = usar cycles)
+  const char *dump_path; // Arquivo de saída ("-" ou NULL = stdout)
+  Replay *replay;        // Entrada gravada (NULL = nenhuma tecla)
+} HeadlessConfig;
+
+int run_headless(CPU *chip, const Scheduler *sched,
+                 const HeadlessConfig *config);
+bool dump_state(const CPU *chip, const char *path);
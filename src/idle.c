@@ -0,0 +1,107 @@
+#include "idle.h"
+
+static bool any_key(const CPU *chip) {
+  for (int k = 0; k < KEYS; k++) {
+    if (chip->keys[k]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static uint16_t opcode_at(const CPU *chip, uint16_t addr) {
+  return (chip->dram.memory[dram_addr(addr)] << 8) |
+         chip->dram.memory[dram_addr(addr + 1)];
+}
+
+// 1NNN tem a mesma decodificação em todos os perfis; comparar o opcode
+// cru descarta quase todos os candidatos sem decodificar nada
+static bool jumps_to(const CPU *chip, uint16_t addr, uint16_t target) {
+  return target <= 0x0FFF && opcode_at(chip, addr) == (0x1000 | target);
+}
+
+// Decodifica sem tocar no cache: a detecção só lê a memória
+static DecodedOp decode_at(const CPU *chip, uint16_t addr) {
+  return decode_op(opcode_at(chip, addr), chip->quirks);
+}
+
+// true se o salto condicional não salta, ou seja, o laço continua
+static bool key_wait_continues(const CPU *chip, const DecodedOp *op) {
+  bool pressed = chip->keys[chip->v[op->x] & 0xF];
+  return op->handler == OP_SKP ? !pressed : pressed;
+}
+
+static bool timer_wait_continues(const DecodedOp *op, uint8_t value) {
+  return op->handler == OP_SE_IMM ? value != op->nn : value == op->nn;
+}
+
+// EX9E/EXA1 seguido de 1NNN de volta, com o PC em qualquer um dos dois
+static bool detect_key_wait(const CPU *chip, IdleLoop *loop) {
+  for (int lead = 0; lead < 2; lead++) {
+    uint16_t head = chip->pc - 2 * lead;
+    if (!jumps_to(chip, head + 2, head)) {
+      continue;
+    }
+    DecodedOp test = decode_at(chip, head);
+    if ((test.handler == OP_SKP || test.handler == OP_SKNP) &&
+        chip->v[test.x] < KEYS && key_wait_continues(chip, &test)) {
+      loop->kind = IDLE_SPIN;
+      loop->period = 2;
+      return true;
+    }
+  }
+  return false;
+}
+
+// FX07, 3XNN/4XNN, 1NNN de volta ao FX07. Com o PC no teste ou no salto
+// as instruções até a cabeça só mudam o PC.
+static bool detect_timer_wait(const CPU *chip, IdleLoop *loop) {
+  for (int lead = 0; lead < 3; lead++) {
+    uint16_t head = chip->pc - 2 * ((3 - lead) % 3);
+    if (!jumps_to(chip, head + 4, head)) {
+      continue;
+    }
+    DecodedOp read = decode_at(chip, head);
+    DecodedOp test = decode_at(chip, head + 2);
+    if (read.handler != OP_LD_VX_DT ||
+        (test.handler != OP_SE_IMM && test.handler != OP_SNE_IMM) ||
+        test.x != read.x || !timer_wait_continues(&test, chip->delay_timer)) {
+      continue;
+    }
+    if (lead == 2 && !timer_wait_continues(&test, chip->v[read.x])) {
+      return false; // O teste ainda vê o valor antigo e sai do laço
+    }
+    loop->kind = IDLE_TIMER;
+    loop->period = 3;
+    loop->lead = lead;
+    loop->x = read.x;
+    loop->head = head;
+    return true;
+  }
+  return false;
+}
+
+bool idle_detect(const CPU *chip, IdleLoop *loop) {
+  loop->kind = IDLE_NONE;
+  uint16_t opcode = opcode_at(chip, chip->pc);
+  uint8_t handler = jumps_to(chip, chip->pc, chip->pc) ? OP_JP
+                    : (opcode & 0xF0FF) == 0xF00A || opcode == 0x00FD
+                        ? decode_op(opcode, chip->quirks).handler
+                        : OP_UNKNOWN;
+  // CALL com a pilha cheia ou RET com ela vazia repete a si mesmo
+  bool stuck = ((opcode & 0xF000) == 0x2000 && chip->sp >= STACK_SIZE) ||
+               ((opcode & 0xF0FF) == 0x00EE && chip->sp == 0);
+  if (handler == OP_JP || handler == OP_EXIT || stuck ||
+      (handler == OP_LD_K && !any_key(chip))) {
+    loop->kind = IDLE_SPIN;
+    loop->period = 1;
+    return true;
+  }
+  return detect_key_wait(chip, loop) || detect_timer_wait(chip, loop);
+}
+
+bool idle_halted(const CPU *chip) {
+  IdleLoop loop;
+  return chip->delay_timer == 0 && chip->sound_timer == 0 &&
+         idle_detect(chip, &loop) && loop.kind == IDLE_SPIN;
+}
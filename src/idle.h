@@ -0,0 +1,32 @@
+#pragma once
+#include "cpu.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Laços de espera reconhecidos no PC atual. Dentro de uma chamada a
+// run_cycles as teclas não mudam, então enquanto o laço continuar cada volta
+// deixa a CPU exatamente no mesmo estado e o escalonador pode avançar o
+// tempo do convidado sem executar as instruções.
+enum {
+  IDLE_NONE = 0,
+  // Nada muda além dos timers: 1NNN para si mesmo, 00FD, FX0A sem tecla,
+  // CALL/RET parado por falha de pilha ou EX9E/EXA1 esperando uma tecla
+  // seguido de 1NNN de volta
+  IDLE_SPIN,
+  // Espera pelo delay timer: FX07, 3XNN/4XNN, 1NNN de volta ao FX07. Só é
+  // estável até o próximo tick.
+  IDLE_TIMER,
+};
+
+typedef struct {
+  uint8_t kind;
+  uint8_t period; // Instruções por volta
+  uint8_t lead;   // Instruções até a cabeça do laço (IDLE_TIMER)
+  uint8_t x;      // Registrador que recebe o delay timer (IDLE_TIMER)
+  uint16_t head;  // Endereço do FX07 (IDLE_TIMER)
+} IdleLoop;
+
+bool idle_detect(const CPU *chip, IdleLoop *loop);
+// A CPU está parada até chegar uma tecla: laço IDLE_SPIN com os timers
+// zerados
+bool idle_halted(const CPU *chip);
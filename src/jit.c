@@ -0,0 +1,813 @@
+#include "jit.h"
+#include "emu.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if JIT_AVAILABLE
+#include <sys/mman.h>
+
+// Pior caso por instrução: teste do orçamento, corpo (2NNN/FX65 com o
+// caminho rápido e o helper) e até duas saídas para fora do bloco
+#define JIT_MAX_INSN_BYTES 128
+#define JIT_MAX_BLOCK_BYTES (JIT_MAX_BLOCK * JIT_MAX_INSN_BYTES + 32)
+#define JIT_TRAMPOLINE_SIZE 128 // Código comum no início do cache
+
+#define OFF_V(r) ((int32_t)(offsetof(struct Chip8, v) + (r)))
+#define OFF_I ((int32_t)offsetof(struct Chip8, i))
+#define OFF_PC ((int32_t)offsetof(struct Chip8, pc))
+#define OFF_DT ((int32_t)offsetof(struct Chip8, delay_timer))
+#define OFF_SP ((int32_t)offsetof(struct Chip8, sp))
+#define OFF_STACK ((int32_t)offsetof(struct Chip8, stack))
+#define OFF_MEM ((int32_t)offsetof(struct Chip8, dram.memory))
+#define OFF_DECODE(a)                                                         \
+  ((int32_t)(offsetof(struct Chip8, decode_cache) + (a) * sizeof(DecodedOp)))
+
+// Códigos de condição do x86 (jcc = 0F 80+cc)
+#define CC_E 0x4
+#define CC_NE 0x5
+
+typedef struct {
+  uint8_t *p;
+} Emitter;
+
+// Salto ainda sem destino: para um rótulo do bloco ou para fora dele
+typedef struct {
+  uint8_t *patch;  // rel32 a corrigir
+  uint16_t target; // Endereço do convidado
+  bool leave;      // Sai mesmo se o destino estiver no bloco (orçamento)
+} Exit;
+
+typedef struct {
+  Emitter e;
+  uint16_t start;
+  uint16_t count;
+  uint8_t *labels[JIT_MAX_BLOCK]; // Início do código de cada instrução
+  Exit exits[2 * JIT_MAX_BLOCK + 1]; // Orçamento e desvio por instrução, fim
+  int exit_count;
+} Block;
+
+static void emit8(Emitter *e, uint8_t b) { *e->p++ = b; }
+
+static void emit32(Emitter *e, int32_t d) {
+  memcpy(e->p, &d, 4);
+  e->p += 4;
+}
+
+static void emit64(Emitter *e, uint64_t q) {
+  memcpy(e->p, &q, 8);
+  e->p += 8;
+}
+
+static void patch_rel32(uint8_t *patch, const uint8_t *target) {
+  int32_t rel = (int32_t)(target - (patch + 4));
+  memcpy(patch, &rel, 4);
+}
+
+// <op> r8, [rbx + disp32]  ou  <op> [rbx + disp32], r8
+static void emit_rbx(Emitter *e, uint8_t opcode, uint8_t reg, int32_t disp) {
+  emit8(e, opcode);
+  emit8(e, 0x83 | (reg << 3)); // mod=10, rm=rbx
+  emit32(e, disp);
+}
+
+static void emit_load_al(Emitter *e, int32_t disp) {
+  emit_rbx(e, 0x8A, 0, disp); // mov al, [rbx+disp]
+}
+
+static void emit_store_al(Emitter *e, int32_t disp) {
+  emit_rbx(e, 0x88, 0, disp); // mov [rbx+disp], al
+}
+
+static void emit_store_cl(Emitter *e, int32_t disp) {
+  emit_rbx(e, 0x88, 1, disp); // mov [rbx+disp], cl
+}
+
+// mov word [rbx+disp], imm16 passando por eax: o prefixo 66 com imediato de
+// 16 bits trava o decodificador (LCP)
+static void emit_store_word(Emitter *e, int32_t disp, uint16_t value) {
+  emit8(e, 0xB8); // mov eax, imm32
+  emit32(e, value);
+  emit8(e, 0x66); // mov [rbx+disp], ax
+  emit_rbx(e, 0x89, 0, disp);
+}
+
+static void emit_store_pc(Emitter *e, uint16_t pc) {
+  emit_store_word(e, OFF_PC, pc);
+}
+
+// Desvio curto para frente; o deslocamento é corrigido com patch_rel8
+static uint8_t *emit_jump8(Emitter *e, uint8_t opcode) {
+  emit8(e, opcode);
+  emit8(e, 0);
+  return e->p - 1;
+}
+
+static void patch_rel8(uint8_t *patch, const uint8_t *target) {
+  *patch = (uint8_t)(target - (patch + 1));
+}
+
+static void emit_dec_budget(Emitter *e) {
+  emit8(e, 0x41); // dec r12d
+  emit8(e, 0xFF);
+  emit8(e, 0xCC);
+}
+
+static void emit_jump(Emitter *e, const uint8_t *target) {
+  emit8(e, 0xE9); // jmp rel32
+  emit32(e, 0);
+  patch_rel32(e->p - 4, target);
+}
+
+// Salto (jmp ou jcc) para um endereço do convidado, resolvido em
+// finish_block
+static void emit_exit(Block *b, int cc, uint16_t target, bool leave) {
+  if (cc < 0) {
+    emit8(&b->e, 0xE9); // jmp rel32
+  } else {
+    emit8(&b->e, 0x0F); // jcc rel32
+    emit8(&b->e, 0x80 | cc);
+  }
+  b->exits[b->exit_count++] = (Exit){b->e.p, target, leave};
+  emit32(&b->e, 0);
+}
+
+// Antes de cada instrução: com o orçamento esgotado (r12d = 0) sai com o PC
+// nela, para que os timers decrementem na instrução exata
+static void emit_budget_check(Block *b, uint16_t addr) {
+  emit8(&b->e, 0x45); // test r12d, r12d
+  emit8(&b->e, 0x85);
+  emit8(&b->e, 0xE4);
+  emit_exit(b, CC_E, addr, true);
+}
+
+// Instruções sem tradução nativa chamam o interpretador do perfil para um
+// único op, já decodificado no cache da CPU
+static void emit_helper(Emitter *e, const CPU *chip, uint16_t addr) {
+  emit8(e, 0x48); // mov rdi, rbx
+  emit8(e, 0x89);
+  emit8(e, 0xDF);
+  emit8(e, 0x48); // lea rsi, [rbx + decode_cache[addr]]
+  emit_rbx(e, 0x8D, 6, OFF_DECODE(addr));
+  emit8(e, 0x48); // mov rax, imm64
+  emit8(e, 0xB8);
+  emit64(e, (uint64_t)(uintptr_t)chip->interp->exec);
+  emit8(e, 0xFF); // call rax
+  emit8(e, 0xD0);
+}
+
+// Retorna true se a instrução foi traduzida para código nativo. As variações
+// de quirks seguem o interpretador, inclusive a ordem em que VX e VF são
+// gravados.
+static bool emit_native(Emitter *e, const DecodedOp *op, uint8_t quirks) {
+  uint8_t shift_src = QUIRK_SHIFT_VY(quirks) ? op->y : op->x;
+  switch (op->handler) {
+  case OP_NOP:
+    return true;
+  case OP_LD_IMM: // mov byte [Vx], nn
+    emit_rbx(e, 0xC6, 0, OFF_V(op->x));
+    emit8(e, op->nn);
+    return true;
+  case OP_ADD_IMM: // add byte [Vx], nn
+    emit_rbx(e, 0x80, 0, OFF_V(op->x));
+    emit8(e, op->nn);
+    return true;
+  case OP_LD_REG:
+    emit_load_al(e, OFF_V(op->y));
+    emit_store_al(e, OFF_V(op->x));
+    return true;
+  case OP_OR:
+  case OP_AND:
+  case OP_XOR:
+    emit_load_al(e, OFF_V(op->y));
+    emit_rbx(e, op->handler == OP_OR    ? 0x08  // or [Vx], al
+                : op->handler == OP_AND ? 0x20  // and [Vx], al
+                                        : 0x30, // xor [Vx], al
+             0, OFF_V(op->x));
+    if (QUIRK_LOGIC_VF(quirks)) {
+      emit_rbx(e, 0xC6, 0, OFF_V(0xF)); // mov byte [VF], 0
+      emit8(e, 0);
+    }
+    return true;
+  case OP_ADD_REG:
+    emit_load_al(e, OFF_V(op->x));
+    emit_rbx(e, 0x02, 0, OFF_V(op->y)); // add al, [Vy]
+    emit8(e, 0x0F);                     // setc cl
+    emit8(e, 0x92);
+    emit8(e, 0xC1);
+    if (QUIRK_FLAG_LAST(quirks)) {
+      emit_store_al(e, OFF_V(op->x));
+      emit_store_cl(e, OFF_V(0xF));
+    } else {
+      emit_store_cl(e, OFF_V(0xF));
+      emit_store_al(e, OFF_V(op->x)); // VX por último, como no interpretador
+    }
+    return true;
+  case OP_SUB:
+  case OP_SUBN: {
+    // VF = minuendo > subtraendo
+    uint8_t a = op->handler == OP_SUB ? op->x : op->y;
+    uint8_t b = op->handler == OP_SUB ? op->y : op->x;
+    emit_load_al(e, OFF_V(a));
+    emit_rbx(e, 0x3A, 0, OFF_V(b)); // cmp al, [b]
+    emit8(e, 0x0F);                 // seta cl
+    emit8(e, 0x97);
+    emit8(e, 0xC1);
+    if (QUIRK_FLAG_LAST(quirks)) {
+      emit_rbx(e, 0x2A, 0, OFF_V(b)); // sub al, [b]
+      emit_store_al(e, OFF_V(op->x));
+      emit_store_cl(e, OFF_V(0xF));
+    } else {
+      // O perfil legado grava VF e relê os operandos
+      emit_store_cl(e, OFF_V(0xF));
+      emit_load_al(e, OFF_V(a));
+      emit_rbx(e, 0x2A, 0, OFF_V(b)); // sub al, [b]
+      emit_store_al(e, OFF_V(op->x));
+    }
+    return true;
+  }
+  case OP_SHR:
+    if (QUIRK_FLAG_LAST(quirks)) {
+      emit_load_al(e, OFF_V(shift_src));
+      emit8(e, 0x88); // mov cl, al
+      emit8(e, 0xC1);
+      emit8(e, 0x80); // and cl, 1
+      emit8(e, 0xE1);
+      emit8(e, 0x01);
+      emit8(e, 0xD0); // shr al, 1
+      emit8(e, 0xE8);
+      emit_store_al(e, OFF_V(op->x));
+      emit_store_cl(e, OFF_V(0xF));
+    } else {
+      emit_load_al(e, OFF_V(op->x));
+      emit8(e, 0x24); // and al, 1
+      emit8(e, 0x01);
+      emit_store_al(e, OFF_V(0xF));
+      emit_rbx(e, 0xD0, 5, OFF_V(op->x)); // shr byte [Vx], 1
+    }
+    return true;
+  case OP_SHL:
+    if (QUIRK_FLAG_LAST(quirks)) {
+      emit_load_al(e, OFF_V(shift_src));
+      emit8(e, 0x88); // mov cl, al
+      emit8(e, 0xC1);
+      emit8(e, 0xC0); // shr cl, 7
+      emit8(e, 0xE9);
+      emit8(e, 0x07);
+      emit8(e, 0x00); // add al, al
+      emit8(e, 0xC0);
+      emit_store_al(e, OFF_V(op->x));
+      emit_store_cl(e, OFF_V(0xF));
+    } else {
+      emit_load_al(e, OFF_V(op->x));
+      emit8(e, 0xC0); // shr al, 7
+      emit8(e, 0xE8);
+      emit8(e, 0x07);
+      emit_store_al(e, OFF_V(0xF));
+      emit_rbx(e, 0xD0, 4, OFF_V(op->x)); // shl byte [Vx], 1
+    }
+    return true;
+  case OP_LD_I:
+    emit_store_word(e, OFF_I, op->nnn);
+    return true;
+  case OP_ADD_I:
+    emit8(e, 0x0F); // movzx eax, byte [Vx]
+    emit_rbx(e, 0xB6, 0, OFF_V(op->x));
+    emit8(e, 0x66); // add [I], ax
+    emit_rbx(e, 0x01, 0, OFF_I);
+    return true;
+  case OP_LD_VX_DT:
+    emit_load_al(e, OFF_DT);
+    emit_store_al(e, OFF_V(op->x));
+    return true;
+  case OP_LD_DT:
+    emit_load_al(e, OFF_V(op->x));
+    emit_store_al(e, OFF_DT);
+    return true;
+  }
+  return false;
+}
+
+// Caminho lento das instruções com tradução parcial: o helper trata os
+// casos raros (falhas, I no fim da memória)
+static void emit_slow_helper(Emitter *e, CPU *chip, const DecodedOp *op,
+                             uint16_t addr) {
+  chip->decode_cache[addr] = *op;
+  emit_store_pc(e, addr + 2);
+  emit_helper(e, chip, addr);
+}
+
+// 2NNN: empilha o retorno e segue direto para NNN. Com a pilha cheia o
+// helper registra a falha.
+static void emit_call(Block *b, struct Jit *jit, CPU *chip,
+                      const DecodedOp *op, uint16_t addr) {
+  Emitter *e = &b->e;
+  emit8(e, 0x0F); // movzx eax, byte [sp]
+  emit_rbx(e, 0xB6, 0, OFF_SP);
+  emit8(e, 0x3C); // cmp al, STACK_SIZE
+  emit8(e, STACK_SIZE);
+  uint8_t *full = emit_jump8(e, 0x73); // jae
+  emit8(e, 0xB9);                      // mov ecx, addr + 2
+  emit32(e, (uint16_t)(addr + 2));
+  emit8(e, 0x66); // mov [rbx + rax*2 + stack], cx
+  emit8(e, 0x89);
+  emit8(e, 0x8C);
+  emit8(e, 0x43);
+  emit32(e, OFF_STACK);
+  emit_rbx(e, 0xFE, 0, OFF_SP); // inc byte [sp]
+  emit_dec_budget(e);
+  emit_exit(b, -1, op->nnn, false);
+
+  patch_rel8(full, e->p);
+  emit_slow_helper(e, chip, op, addr);
+  emit_dec_budget(e);
+  emit_jump(e, jit->dispatch);
+}
+
+// 00EE: desempilha o PC e despacha para ele. Com a pilha vazia o helper
+// registra a falha.
+static void emit_ret(Emitter *e, struct Jit *jit, CPU *chip,
+                     const DecodedOp *op, uint16_t addr) {
+  emit8(e, 0x0F); // movzx eax, byte [sp]
+  emit_rbx(e, 0xB6, 0, OFF_SP);
+  emit8(e, 0x84); // test al, al
+  emit8(e, 0xC0);
+  uint8_t *empty = emit_jump8(e, 0x74); // jz
+  emit8(e, 0xFE);                       // dec al
+  emit8(e, 0xC8);
+  emit_store_al(e, OFF_SP);
+  emit8(e, 0x0F); // movzx eax, word [rbx + rax*2 + stack]
+  emit8(e, 0xB7);
+  emit8(e, 0x84);
+  emit8(e, 0x43);
+  emit32(e, OFF_STACK);
+  emit8(e, 0x66); // mov [pc], ax
+  emit_rbx(e, 0x89, 0, OFF_PC);
+  uint8_t *join = emit_jump8(e, 0xEB); // jmp
+
+  patch_rel8(empty, e->p);
+  emit_slow_helper(e, chip, op, addr);
+  patch_rel8(join, e->p);
+  emit_dec_budget(e);
+  emit_jump(e, jit->dispatch);
+}
+
+// Copia len bytes (1 a 16) de [rcx] para [rbx + disp] com dois acessos
+// que se sobrepõem, da maior largura que cabe
+static void emit_copy_from_rcx(Emitter *e, int len, int32_t disp) {
+  int width = len >= 8 ? 8 : len >= 4 ? 4 : len >= 2 ? 2 : 1;
+  int offsets[2] = {0, len - width};
+  for (int n = 0; n < (width == len ? 1 : 2); n++) {
+    // mov dl/dx/edx/rdx, [rcx + off]
+    if (width == 2) {
+      emit8(e, 0x66);
+    } else if (width == 8) {
+      emit8(e, 0x48);
+    }
+    emit8(e, width == 1 ? 0x8A : 0x8B);
+    emit8(e, 0x51);
+    emit8(e, (uint8_t)offsets[n]);
+    // mov [rbx + disp + off], dl/dx/edx/rdx
+    if (width == 2) {
+      emit8(e, 0x66);
+    } else if (width == 8) {
+      emit8(e, 0x48);
+    }
+    emit_rbx(e, width == 1 ? 0x88 : 0x89, 2, disp + offsets[n]);
+  }
+}
+
+// FX65: V0..VX lidos direto da memória quando I + X + 1 não passa do fim
+// dela; senão o helper faz a volta nos endereços
+static void emit_ld_regs(Emitter *e, CPU *chip, const DecodedOp *op,
+                         uint16_t addr) {
+  int len = op->x + 1;
+  emit8(e, 0x0F); // movzx eax, word [I]
+  emit_rbx(e, 0xB7, 0, OFF_I);
+  if (MEMORY_SIZE < 0x10000) {
+    emit8(e, 0x25); // and eax, MEMORY_SIZE - 1 (I dá a volta na memória)
+    emit32(e, MEMORY_SIZE - 1);
+  }
+  emit8(e, 0x3D); // cmp eax, MEMORY_SIZE - len
+  emit32(e, MEMORY_SIZE - len);
+  uint8_t *wraps = emit_jump8(e, 0x77); // ja
+  emit8(e, 0x48);                       // lea rcx, [rbx + rax + memory]
+  emit8(e, 0x8D);
+  emit8(e, 0x8C);
+  emit8(e, 0x03);
+  emit32(e, OFF_MEM);
+  emit_copy_from_rcx(e, len, OFF_V(0));
+  int step = QUIRK_I_STEP(chip->quirks, op->x);
+  if (step) {
+    emit8(e, 0x66); // add word [I], imm8
+    emit_rbx(e, 0x83, 0, OFF_I);
+    emit8(e, (uint8_t)step);
+  }
+  uint8_t *join = emit_jump8(e, 0xEB); // jmp
+
+  patch_rel8(wraps, e->p);
+  emit_slow_helper(e, chip, op, addr);
+  patch_rel8(join, e->p);
+}
+
+// Saltos condicionais traduzidos como desvios dentro do bloco. Retorna o
+// código de condição em que a próxima instrução é saltada, ou -1.
+static int emit_skip_compare(Emitter *e, const DecodedOp *op) {
+  switch (op->handler) {
+  case OP_SE_IMM:
+  case OP_SNE_IMM:
+    emit_rbx(e, 0x80, 7, OFF_V(op->x)); // cmp byte [Vx], nn
+    emit8(e, op->nn);
+    return op->handler == OP_SE_IMM ? CC_E : CC_NE;
+  case OP_SE_REG:
+  case OP_SNE_REG:
+    emit_load_al(e, OFF_V(op->x));
+    emit_rbx(e, 0x3A, 0, OFF_V(op->y)); // cmp al, [Vy]
+    return op->handler == OP_SE_REG ? CC_E : CC_NE;
+  case OP_SKIP_XOR: // V0 ^ V1 == 0
+    emit_load_al(e, OFF_V(0));
+    emit_rbx(e, 0x3A, 0, OFF_V(1));
+    return CC_E;
+  }
+  return -1;
+}
+
+static bool is_skip(uint8_t handler) {
+  switch (handler) {
+  case OP_SE_IMM:
+  case OP_SNE_IMM:
+  case OP_SE_REG:
+  case OP_SNE_REG:
+  case OP_SKIP_XOR:
+    return true;
+  }
+  return false;
+}
+
+// Destino do salto condicional em addr. No XO-CHIP a F000 NNNN seguinte é
+// saltada inteira; a palavra lida passa a fazer parte do bloco.
+static uint16_t skip_target(struct Jit *jit, const CPU *chip, uint16_t addr,
+                            uint8_t handler) {
+  if (handler == OP_SKIP_XOR || !QUIRK_XO(chip->quirks)) {
+    return addr + 4;
+  }
+  uint16_t next = dram_addr(addr + 2);
+  jit->covered[next] = 1;
+  jit->covered[dram_addr(next + 1)] = 1;
+  const uint8_t *mem = chip->dram.memory;
+  return mem[next] == 0xF0 && mem[dram_addr(next + 1)] == 0x00 ? addr + 6
+                                                               : addr + 4;
+}
+
+// Escritas na memória: podem descartar o cache, inclusive o bloco atual
+static bool writes_memory(uint8_t handler) {
+  switch (handler) {
+  case OP_ST_VX:
+  case OP_BCD:
+  case OP_ST_REGS:
+  case OP_ST_RANGE:
+    return true;
+  }
+  return false;
+}
+
+// Depois de uma escrita o PC é a instrução seguinte; só segue direto para
+// ela se o cache não foi descartado
+static void emit_after_store(Block *b, struct Jit *jit, uint16_t next) {
+  Emitter *e = &b->e;
+  emit8(e, 0x48); // mov rax, &jit->generation
+  emit8(e, 0xB8);
+  emit64(e, (uint64_t)(uintptr_t)&jit->generation);
+  emit8(e, 0x81); // cmp dword [rax], generation
+  emit8(e, 0x38);
+  emit32(e, (int32_t)jit->generation);
+  emit8(e, 0x0F); // jne despacho
+  emit8(e, 0x85);
+  emit32(e, 0);
+  patch_rel32(e->p - 4, jit->dispatch);
+  emit_exit(b, -1, next, false);
+}
+
+// Instruções que alteram o fluxo de forma dinâmica ou escrevem na memória
+// encerram o bloco
+static bool ends_block(uint8_t handler) {
+  switch (handler) {
+  case OP_RET:
+  case OP_JP:
+  case OP_CALL:
+  case OP_JP_V0:
+  case OP_SKP:
+  case OP_SKNP:
+  case OP_LD_K:
+  case OP_ST_VX:
+  case OP_BCD:
+  case OP_ST_REGS:
+  case OP_ST_RANGE:
+  case OP_LD_LONG: // Avança o PC mais 2 bytes
+  case OP_EXIT:
+  case OP_UNKNOWN:
+    return true;
+  }
+  return false;
+}
+
+// Troca a proteção do cache inteiro: gravável para emitir, executável para
+// rodar. Só muda quando há tradução nova, não a cada bloco executado.
+static bool set_writable(struct Jit *jit, bool writable) {
+  if (jit->writable == writable) {
+    return true;
+  }
+  int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC;
+  if (mprotect(jit->code, JIT_CODE_SIZE, prot) != 0) {
+    perror("Erro ao alterar a proteção do cache do JIT");
+    return false;
+  }
+  jit->writable = writable;
+  return true;
+}
+
+// Com XOCHIP_MEMORY todo endereço de 16 bits está na memória
+static inline bool in_memory(uint16_t addr) {
+#if MEMORY_SIZE < 0x10000
+  return addr < MEMORY_SIZE;
+#else
+  (void)addr;
+  return true;
+#endif
+}
+
+// Liga os saltos aos rótulos do bloco ou ao código já traduzido do destino.
+// Os demais ganham um trecho que grava o PC e vai para o despacho (ou, sem
+// orçamento, para o epílogo).
+static void finish_block(struct Jit *jit, Block *b) {
+  uint8_t *stubs[2 * JIT_MAX_BLOCK + 1];
+  const Exit *stub_exits[2 * JIT_MAX_BLOCK + 1];
+  int stub_count = 0;
+  for (int n = 0; n < b->exit_count; n++) {
+    const Exit *out = &b->exits[n];
+    uint16_t offset = out->target - b->start;
+    if (!out->leave && out->target >= b->start && offset % 2 == 0 &&
+        offset / 2 < b->count) {
+      patch_rel32(out->patch, b->labels[offset / 2]);
+      continue;
+    }
+    if (!out->leave && in_memory(out->target) &&
+        jit->entry[out->target] != NULL) {
+      patch_rel32(out->patch, jit->entry[out->target]);
+      continue;
+    }
+    int s = 0;
+    while (s < stub_count && (stub_exits[s]->target != out->target ||
+                              stub_exits[s]->leave != out->leave)) {
+      s++;
+    }
+    if (s == stub_count) {
+      stubs[s] = b->e.p;
+      stub_exits[s] = out;
+      stub_count++;
+      emit_store_pc(&b->e, out->target);
+      emit_jump(&b->e, out->leave ? jit->exit_code : jit->dispatch);
+    }
+    patch_rel32(out->patch, stubs[s]);
+  }
+}
+
+// Blocos começam em qualquer endereço; cada instrução traduzida vira uma
+// entrada, então o início de um frame no meio de um bloco já traduzido não
+// gera uma nova tradução. O orçamento fica em r12d e é testado antes de
+// cada instrução.
+static const uint8_t *translate(struct Jit *jit, CPU *chip, uint16_t start) {
+  if (!set_writable(jit, true)) {
+    return NULL;
+  }
+  if (JIT_CODE_SIZE - jit->used < JIT_MAX_BLOCK_BYTES) {
+    jit_flush(jit);
+  }
+
+  Block b = {.e = {jit->code + jit->used}, .start = start};
+  uint16_t addr = start;
+  bool jumped = false;
+  uint8_t last = OP_NOP;
+  while (b.count < JIT_MAX_BLOCK) {
+    const uint8_t *mem = chip->dram.memory;
+    DecodedOp op =
+        decode_op((mem[addr] << 8) | mem[dram_addr(addr + 1)], chip->quirks);
+    jit->covered[addr] = 1;
+    jit->covered[dram_addr(addr + 1)] = 1;
+    b.labels[b.count++] = b.e.p;
+    emit_budget_check(&b, addr);
+    last = op.handler;
+
+    if (op.handler == OP_JP) {
+      // Saltos para trás dentro do bloco viram laços nativos
+      emit_dec_budget(&b.e);
+      emit_exit(&b, -1, op.nnn, false);
+      jumped = true;
+    } else if (op.handler == OP_CALL) {
+      emit_call(&b, jit, chip, &op, addr);
+      jumped = true;
+    } else if (op.handler == OP_RET) {
+      emit_ret(&b.e, jit, chip, &op, addr);
+      jumped = true;
+    } else if (op.handler == OP_LD_REGS) {
+      emit_ld_regs(&b.e, chip, &op, addr);
+      emit_dec_budget(&b.e);
+    } else if (is_skip(op.handler)) {
+      int cc = emit_skip_compare(&b.e, &op);
+      emit8(&b.e, 0x45); // lea r12d, [r12 - 1] (preserva as flags)
+      emit8(&b.e, 0x8D);
+      emit8(&b.e, 0x64);
+      emit8(&b.e, 0x24);
+      emit8(&b.e, 0xFF);
+      emit_exit(&b, cc, skip_target(jit, chip, addr, op.handler), false);
+    } else if (emit_native(&b.e, &op, chip->quirks)) {
+      emit_dec_budget(&b.e);
+    } else {
+      emit_slow_helper(&b.e, chip, &op, addr);
+      emit_dec_budget(&b.e);
+    }
+
+    addr += 2;
+    // Fim da memória: o interpretador continua a partir daqui
+    if (ends_block(op.handler) || addr > MEMORY_SIZE - 2) {
+      break;
+    }
+  }
+
+  if (writes_memory(last)) {
+    emit_after_store(&b, jit, addr);
+  } else if (ends_block(last) && !jumped) {
+    emit_jump(&b.e, jit->dispatch); // O helper já gravou o PC
+  } else if (!jumped) {
+    emit_exit(&b, -1, addr, false);
+  }
+  finish_block(jit, &b);
+
+  jit->used = b.e.p - jit->code;
+  for (uint16_t n = 0; n < b.count; n++) {
+    if (jit->entry[start + 2 * n] == NULL) {
+      jit->entry[start + 2 * n] = b.labels[n];
+    }
+  }
+  return b.labels[0];
+}
+
+// Prólogo e epílogo comuns, gravados uma vez no início do cache (pilha
+// alinhada em 16 para as chamadas aos helpers)
+static void emit_trampoline(struct Jit *jit) {
+  Emitter e = {jit->code};
+  jit->enter = (JitEnterFn)(void *)e.p;
+  emit8(&e, 0x53); // push rbx
+  emit8(&e, 0x41); // push r12
+  emit8(&e, 0x54);
+  emit8(&e, 0x56); // push rsi (orçamento inicial)
+  emit8(&e, 0x48); // mov rbx, rdi
+  emit8(&e, 0x89);
+  emit8(&e, 0xFB);
+  emit8(&e, 0x41); // mov r12d, esi
+  emit8(&e, 0x89);
+  emit8(&e, 0xF4);
+  emit8(&e, 0xFF); // jmp rdx
+  emit8(&e, 0xE2);
+
+  // Despacho: PC gravado pelo bloco que terminou; sem código traduzido para
+  // ele volta para jit_run, que traduz ou interpreta
+  jit->dispatch = e.p;
+  emit8(&e, 0x0F); // movzx eax, word [rbx+pc]
+  emit_rbx(&e, 0xB7, 0, OFF_PC);
+  emit8(&e, 0x3D); // cmp eax, MEMORY_SIZE
+  emit32(&e, MEMORY_SIZE);
+  emit8(&e, 0x0F); // jae epílogo
+  emit8(&e, 0x83);
+  uint8_t *out_of_memory = e.p;
+  emit32(&e, 0);
+  emit8(&e, 0x48); // mov rcx, jit->entry
+  emit8(&e, 0xB9);
+  emit64(&e, (uint64_t)(uintptr_t)jit->entry);
+  emit8(&e, 0x48); // mov rax, [rcx + rax*8]
+  emit8(&e, 0x8B);
+  emit8(&e, 0x04);
+  emit8(&e, 0xC1);
+  emit8(&e, 0x48); // test rax, rax
+  emit8(&e, 0x85);
+  emit8(&e, 0xC0);
+  emit8(&e, 0x0F); // jz epílogo
+  emit8(&e, 0x84);
+  uint8_t *untranslated = e.p;
+  emit32(&e, 0);
+  emit8(&e, 0xFF); // jmp rax
+  emit8(&e, 0xE0);
+
+  jit->exit_code = e.p; // eax = orçamento inicial - restante
+  patch_rel32(out_of_memory, jit->exit_code);
+  patch_rel32(untranslated, jit->exit_code);
+  emit8(&e, 0x8B);      // mov eax, [rsp]
+  emit8(&e, 0x04);
+  emit8(&e, 0x24);
+  emit8(&e, 0x44); // sub eax, r12d
+  emit8(&e, 0x29);
+  emit8(&e, 0xE0);
+  emit8(&e, 0x5E); // pop rsi
+  emit8(&e, 0x41); // pop r12
+  emit8(&e, 0x5C);
+  emit8(&e, 0x5B); // pop rbx
+  emit8(&e, 0xC3); // ret
+}
+
+struct Jit *jit_create(void) {
+  struct Jit *jit = (struct Jit *)calloc(1, sizeof(struct Jit));
+  if (jit == NULL) {
+    fprintf(stderr, "Erro: Falha ao alocar memória para o JIT.\n");
+    return NULL;
+  }
+  // Nunca gravável e executável ao mesmo tempo: as páginas nascem RW e
+  // viram RX antes de rodar (set_writable)
+  void *code = mmap(NULL, JIT_CODE_SIZE, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (code == MAP_FAILED) {
+    perror("Erro ao alocar o cache de código do JIT");
+    free(jit);
+    return NULL;
+  }
+  jit->code = (uint8_t *)code;
+  jit->writable = true;
+  emit_trampoline(jit);
+  jit->used = JIT_TRAMPOLINE_SIZE;
+  return jit;
+}
+
+void jit_destroy(struct Jit *jit) {
+  if (jit) {
+    munmap(jit->code, JIT_CODE_SIZE);
+    free(jit);
+  }
+}
+
+void jit_flush(struct Jit *jit) {
+  jit->used = JIT_TRAMPOLINE_SIZE;
+  jit->generation++;
+  memset(jit->entry, 0, sizeof(jit->entry));
+  memset(jit->covered, 0, sizeof(jit->covered));
+}
+
+void jit_invalidate(struct Jit *jit, uint16_t addr, uint16_t len) {
+  // Escrita sobre código traduzido: descarta todo o cache de código. O caso
+  // comum (sem dar a volta na memória) é uma busca só.
+  if (addr + len <= MEMORY_SIZE) {
+    if (memchr(&jit->covered[addr], 1, len) != NULL) {
+      jit_flush(jit);
+    }
+    return;
+  }
+  for (uint16_t n = 0; n < len; n++) {
+    if (jit->covered[dram_addr(addr + n)]) {
+      jit_flush(jit);
+      return;
+    }
+  }
+}
+
+uint64_t jit_run(struct Jit *jit, CPU *chip, uint64_t count) {
+  uint64_t done = 0;
+  while (done < count) {
+    const uint8_t *code = NULL;
+    if (chip->pc == dram_addr(chip->pc)) { // PC dentro da memória
+      code = jit->entry[chip->pc];
+      if (code == NULL) {
+        code = translate(jit, chip, chip->pc);
+      }
+    }
+    if (code == NULL || !set_writable(jit, false)) {
+      emu(chip);
+      done++;
+      continue;
+    }
+    // Uma escrita dentro do bloco pode descartar o cache (e o próprio
+    // bloco), mas o código segue intacto até a próxima tradução
+    uint64_t left = count - done;
+    done += jit->enter(chip, left > UINT32_MAX ? UINT32_MAX : (uint32_t)left,
+                       code);
+  }
+  return done;
+}
+
+#else
+
+struct Jit *jit_create(void) { return NULL; }
+void jit_destroy(struct Jit *jit) { (void)jit; }
+void jit_flush(struct Jit *jit) { (void)jit; }
+void jit_invalidate(struct Jit *jit, uint16_t addr, uint16_t len) {
+  (void)jit;
+  (void)addr;
+  (void)len;
+}
+uint64_t jit_run(struct Jit *jit, CPU *chip, uint64_t count) {
+  (void)jit;
+  for (uint64_t n = 0; n < count; n++) {
+    emu(chip);
+  }
+  return count;
+}
+
+#endif
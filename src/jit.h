@@ -0,0 +1,41 @@
+#pragma once
+#include "cpu.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Recompilador dinâmico de blocos básicos para x86-64 (Linux). Em outras
+// plataformas jit_create() retorna NULL e o interpretador é usado.
+#if defined(__x86_64__) && defined(__linux__)
+#define JIT_AVAILABLE 1
+#else
+#define JIT_AVAILABLE 0
+#endif
+
+#define JIT_CODE_SIZE (1024 * 1024)
+#define JIT_MAX_BLOCK 64 // Instruções por bloco
+
+// Prólogo comum: entra no código traduzido em `code` e executa no máximo
+// `budget` instruções (budget >= 1). Retorna quantas executou; o PC fica na
+// próxima instrução.
+typedef uint32_t (*JitEnterFn)(struct Chip8 *chip, uint32_t budget,
+                               const uint8_t *code);
+
+struct Jit {
+  uint8_t *code;  // Cache de código: gravável ou executável, nunca os dois
+  bool writable;  // Estado atual das páginas (W^X)
+  size_t used;
+  uint32_t generation; // Incrementada a cada jit_flush
+  JitEnterFn enter;         // Prólogo no início do cache
+  const uint8_t *exit_code; // Epílogo: volta para jit_run
+  const uint8_t *dispatch;  // Segue para o código do PC atual, se houver
+  // Código de cada endereço, inclusive no meio de um bloco (NULL = ainda
+  // não traduzido)
+  const uint8_t *entry[MEMORY_SIZE];
+  uint8_t covered[MEMORY_SIZE]; // Bytes da memória com código traduzido
+};
+
+struct Jit *jit_create(void);
+void jit_destroy(struct Jit *jit);
+void jit_flush(struct Jit *jit);
+void jit_invalidate(struct Jit *jit, uint16_t addr, uint16_t len);
+uint64_t jit_run(struct Jit *jit, CPU *chip, uint64_t count);
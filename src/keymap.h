@@ -0,0 +1,47 @@
+#pragma once
+
+// Teclado hexadecimal do COSMAC VIP no lado esquerdo de um teclado QWERTY:
+//   1 2 3 C      1 2 3 4
+//   4 5 6 D  <-  q w e r
+//   7 8 9 E      a s d f
+//   A 0 B F      z x c v
+// Recebe o caractere em minúscula (os SDLK_ dessas teclas são o próprio
+// ASCII); -1 para qualquer outra tecla.
+static inline int keymap_from_char(int c) {
+  switch (c) {
+  case '1':
+    return 0x1;
+  case '2':
+    return 0x2;
+  case '3':
+    return 0x3;
+  case '4':
+    return 0xC;
+  case 'q':
+    return 0x4;
+  case 'w':
+    return 0x5;
+  case 'e':
+    return 0x6;
+  case 'r':
+    return 0xD;
+  case 'a':
+    return 0x7;
+  case 's':
+    return 0x8;
+  case 'd':
+    return 0x9;
+  case 'f':
+    return 0xE;
+  case 'z':
+    return 0xA;
+  case 'x':
+    return 0x0;
+  case 'c':
+    return 0xB;
+  case 'v':
+    return 0xF;
+  default:
+    return -1;
+  }
+}
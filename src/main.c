@@ -1,53 +1,346 @@
+#include "audio.h"
 #include "cpu.h"
-#include "emu.h"
 #include "files.h"
+#include "headless.h"
+#include "jit.h"
+#include "pack.h"
+#include "pipeline.h"
+#include "profile.h"
+#include "replay.h"
 #include "render.h"
+#include "sched.h"
+#include "trace.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
+static void usage(const char *prog) {
+  fprintf(stderr, "Uso: %s [opções] <caminho_para_o_arquivo_de_ROM>\n", prog);
+  fprintf(stderr, "  --headless      Executa sem SDL (sem janela e sem áudio)\n");
+  fprintf(stderr, "  --cycles N      Modo headless: executa N instruções\n");
+  fprintf(stderr, "  --frames N      Modo headless: executa N frames\n");
+  fprintf(stderr, "  --dump ARQUIVO  Modo headless: grava tela e registradores\n");
+  fprintf(stderr, "  --ipf N         Instruções por frame (padrão: %d)\n",
+          DEFAULT_CYCLES_PER_FRAME);
+  fprintf(stderr, "  --turbo         Não limita a velocidade a 60 frames/s\n");
+  fprintf(stderr, "  --vsync         Apresenta sincronizado com o monitor\n");
+  fprintf(stderr, "  --frame-stats   Mostra p50/p99/máx do tempo de frame\n");
+  fprintf(stderr, "  --filter NOME   Ampliação: nearest (padrão), scale2x, "
+                  "scale3x ou crt\n");
+  fprintf(stderr, "  --no-idle-skip  Executa os laços de espera instrução por "
+                  "instrução\n");
+  fprintf(stderr, "  --jit           Usa o recompilador x86-64 no lugar do "
+                  "interpretador\n");
+  fprintf(stderr, "  --pack ARQUIVO  Lê a ROM (pelo nome) de um pacote de "
+                  "ROMs\n");
+  fprintf(stderr, "  --seed N        Semente do gerador do CXNN\n");
+  fprintf(stderr, "  --quirks PERFIL legacy (padrão), vip, chip48,\n"
+                  "                  schip ou xochip\n");
+  fprintf(stderr, "  --record ARQ    Grava as teclas da sessão em ARQ\n");
+  fprintf(stderr, "  --replay ARQ    Reproduz uma sessão gravada (também no "
+                  "modo headless)\n");
+  fprintf(stderr, "  --trace ARQ     Grava um trace binário de cada instrução "
+                  "(ver chip8-trace)\n");
+}
+
+static bool parse_count(const char *text, uint64_t *out) {
+  char *end = NULL;
+  unsigned long long value = strtoull(text, &end, 0);
+  if (end == text || *end != '\0') {
+    return false;
+  }
+  *out = value;
+  return true;
+}
+
+#ifdef PROFILE_MODE
+// O relatório sai ao terminar o processo, por qualquer caminho
+static struct Profile *exit_profile;
+
+static void write_exit_profile(void) {
+  profile_write_report(exit_profile);
+  profile_free(exit_profile);
+}
+#endif
 
 int main(int argc, char **argv) {
-  if (argc < 2) {
+  const char *rom_path = NULL;
+  const char *pack_path = NULL;
+  const char *record_path = NULL;
+  const char *replay_path = NULL;
+  const char *trace_path = NULL;
+  uint64_t seed = 0;
+  int quirks = QUIRKS_LEGACY;
+  bool headless = false;
+  bool use_jit = false;
+  bool vsync = false;
+  bool frame_stats = false;
+  int filter = UPSCALE_NEAREST;
+  HeadlessConfig headless_config = {0};
+  Scheduler sched;
+  initScheduler(&sched);
+
+  for (int a = 1; a < argc; a++) {
+    if (strcmp(argv[a], "--headless") == 0) {
+      headless = true;
+    } else if (strcmp(argv[a], "--cycles") == 0 && a + 1 < argc) {
+      if (!parse_count(argv[++a], &headless_config.cycles)) {
+        fprintf(stderr, "Erro: Valor inválido para --cycles: %s\n", argv[a]);
+        return -1;
+      }
+    } else if (strcmp(argv[a], "--frames") == 0 && a + 1 < argc) {
+      if (!parse_count(argv[++a], &headless_config.frames)) {
+        fprintf(stderr, "Erro: Valor inválido para --frames: %s\n", argv[a]);
+        return -1;
+      }
+    } else if (strcmp(argv[a], "--ipf") == 0 && a + 1 < argc) {
+      uint64_t ipf;
+      if (!parse_count(argv[++a], &ipf) || ipf == 0 || ipf > UINT32_MAX) {
+        fprintf(stderr, "Erro: Valor inválido para --ipf: %s\n", argv[a]);
+        return -1;
+      }
+      sched.cycles_per_frame = (uint32_t)ipf;
+    } else if (strcmp(argv[a], "--turbo") == 0) {
+      sched.turbo = true;
+    } else if (strcmp(argv[a], "--vsync") == 0) {
+      vsync = true;
+    } else if (strcmp(argv[a], "--frame-stats") == 0) {
+      frame_stats = true;
+    } else if (strcmp(argv[a], "--filter") == 0 && a + 1 < argc) {
+      filter = upscale_filter_from_name(argv[++a]);
+      if (filter < 0) {
+        fprintf(stderr, "Erro: Filtro desconhecido: %s\n", argv[a]);
+        return -1;
+      }
+    } else if (strcmp(argv[a], "--no-idle-skip") == 0) {
+      sched.idle_skip = false;
+    } else if (strcmp(argv[a], "--jit") == 0) {
+      use_jit = true;
+    } else if (strcmp(argv[a], "--pack") == 0 && a + 1 < argc) {
+      pack_path = argv[++a];
+    } else if (strcmp(argv[a], "--seed") == 0 && a + 1 < argc) {
+      if (!parse_count(argv[++a], &seed) || seed > UINT32_MAX) {
+        fprintf(stderr, "Erro: Valor inválido para --seed: %s\n", argv[a]);
+        return -1;
+      }
+    } else if (strcmp(argv[a], "--quirks") == 0 && a + 1 < argc) {
+      quirks = quirks_from_name(argv[++a]);
+      if (quirks < 0) {
+        fprintf(stderr, "Erro: Perfil desconhecido: %s\n", argv[a]);
+        return -1;
+      }
+    } else if (strcmp(argv[a], "--record") == 0 && a + 1 < argc) {
+      record_path = argv[++a];
+    } else if (strcmp(argv[a], "--replay") == 0 && a + 1 < argc) {
+      replay_path = argv[++a];
+    } else if (strcmp(argv[a], "--trace") == 0 && a + 1 < argc) {
+      trace_path = argv[++a];
+    } else if (strcmp(argv[a], "--dump") == 0 && a + 1 < argc) {
+      headless_config.dump_path = argv[++a];
+    } else if (argv[a][0] == '-' && argv[a][1] == '-') {
+      fprintf(stderr, "Erro: Opção desconhecida: %s\n", argv[a]);
+      usage(argv[0]);
+      return -1;
+    } else {
+      rom_path = argv[a];
+    }
+  }
+
+  if (rom_path == NULL) {
     fprintf(stderr, "Erro: Arquivo de ROM não especificado.\n");
-    fprintf(stderr, "Uso: %s <caminho_para_o_arquivo_de_ROM>\n", argv[0]);
+    usage(argv[0]);
     return -1;
   }
 
-  FILEDRAM *file = initFILE(argv[1]);
-  if (file == NULL) {
-    fprintf(stderr, "Erro: Falha ao abrir o arquivo %s.\n", argv[1]);
+#ifdef PROFILE_MODE
+  // O JIT não passa por emu(): com o profiler tudo roda no interpretador
+  if (use_jit) {
+    fprintf(stderr, "Profiler ativo: ignorando --jit.\n");
+    use_jit = false;
+  }
+#endif
+
+  if (record_path && (replay_path || headless)) {
+    fprintf(stderr, "Erro: --record só vale no modo com janela e sem "
+                    "--replay.\n");
     return -1;
   }
+
   CPU chip;
-  Display display;
   initCPU(&chip);
-  initROM(&chip, file);
-  if (!initialize_display(&display)) {
+  set_quirks(&chip, (uint8_t)quirks);
+  uint64_t rom_hash;
+  if (pack_path) {
+    RomPack pack;
+    if (!pack_open(&pack, pack_path)) {
+      return -1;
+    }
+    const PackEntry *entry = pack_find(&pack, rom_path);
+    if (entry == NULL) {
+      fprintf(stderr, "Erro: %s não está no pacote %s.\n", rom_path, pack_path);
+      return -1;
+    }
+    if (!initROMData(&chip, pack_data(&pack, entry), entry->size)) {
+      return -1;
+    }
+    rom_hash = entry->hash;
+    pack_close(&pack);
+  } else {
+    FILEDRAM *file = initFILE(rom_path);
+    if (file == NULL) {
+      fprintf(stderr, "Erro: Falha ao abrir o arquivo %s.\n", rom_path);
+      return -1;
+    }
+    initROM(&chip, file);
+    rom_hash = pack_hash(file->buffer, (size_t)file->size);
+    freeFILE(file);
+  }
+  if (seed) {
+    seedCPU(&chip, (uint32_t)seed);
+  }
+
+  // A gravação define semente e ritmo dos timers para a execução ser idêntica
+  static Replay replay;
+  if (replay_path) {
+    if (!replay_load(&replay, replay_path)) {
+      return -1;
+    }
+    if (replay.header.rom_hash != rom_hash) {
+      fprintf(stderr, "Aviso: a gravação foi feita com outra ROM.\n");
+    }
+    seedCPU(&chip, replay.header.seed);
+    set_quirks(&chip, (uint8_t)replay.header.quirks);
+    sched.cycles_per_frame = replay.header.cycles_per_frame;
+    headless_config.replay = &replay;
+  }
+  if (use_jit) {
+    chip.jit = jit_create();
+    if (chip.jit == NULL) {
+      fprintf(stderr, "JIT indisponível, usando o interpretador.\n");
+    }
+  }
+#ifdef PROFILE_MODE
+  chip.profile = profile_create();
+  if (chip.profile == NULL) {
+    return -1;
+  }
+  exit_profile = chip.profile;
+  atexit(write_exit_profile);
+#endif
+  // Com o trace toda instrução passa pelo interpretador (sem JIT e sem
+  // pular laços de espera) para gerar o seu registro
+  if (trace_path) {
+    chip.trace = trace_open(trace_path, &chip);
+    if (chip.trace == NULL) {
+      return -1;
+    }
+  }
+
+  if (headless) {
+    int status = run_headless(&chip, &sched, &headless_config);
+    trace_close(chip.trace);
+    return status;
+  }
+
+  Display display;
+  static Audio audio;
+  static Pipeline pipeline;
+  if (!initialize_display(&display, vsync, filter)) {
     return -1;
   }
+  init_audio(&audio, &chip);
+  static Recorder recorder;
+  if (record_path) {
+    if (!recorder_open(&recorder, record_path, &chip, &sched, rom_hash)) {
+      return -1;
+    }
+    pipeline.recorder = &recorder;
+  }
+  pipeline.replay = replay_path ? &replay : NULL;
+  pipeline.print_stats = frame_stats;
+  if (!pipeline_start(&pipeline, &chip, &sched, &audio)) {
+    return -1;
+  }
+
+  // A partir daqui o chip pertence à thread de emulação; esta thread só
+  // trata eventos e apresenta os frames publicados no buffer triplo.
   bool running = true;
+  bool repaint = false;
   SDL_Event event;
+  uint32_t last_present = 0;
+  uint64_t frequency = SDL_GetPerformanceFrequency();
+  static FrameStats present_stats;
+  static FrameStats input_stats;
+  frame_stats_init(&present_stats);
+  frame_stats_init(&input_stats);
 
   while (running) {
 
-    int keys[KEYS] = {0};
-
     while (SDL_PollEvent(&event)) {
       
       if (event.type == SDL_QUIT) {
         printf("Fim\n");
         running = false;
+      } else if (event.type == SDL_WINDOWEVENT) {
+        // Janela exposta ou redimensionada: precisa apresentar de novo
+        // Sem memória para a nova área a imagem fica no tamanho anterior
+        if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED &&
+            !resize_display(&display)) {
+          fprintf(stderr, "A imagem mantém o tamanho anterior.\n");
+        }
+        repaint = true;
       } else if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
-
-        processInput(&chip, &event);
+        bool down = event.type == SDL_KEYDOWN;
+        int key = chip8_key(event.key.keysym.sym);
+        if (key >= 0) {
+          pipeline_send_key(&pipeline, key, down);
+        } else if (event.key.keysym.sym == SDLK_F5 && down) {
+          pipeline_send_command(&pipeline, PIPELINE_SAVE, true);
+        } else if (event.key.keysym.sym == SDLK_F9 && down) {
+          pipeline_send_command(&pipeline, PIPELINE_LOAD, true);
+        } else if (event.key.keysym.sym == SDLK_BACKSPACE) {
+          pipeline_send_command(&pipeline, PIPELINE_REWIND, down);
+        }
       }
     }
-    emu(&chip);
-    handle_audio(&chip);
-
-    render_screen(&chip, &display);
 
-    SDL_Delay(16);
+    // Em modo turbo apresenta no máximo um frame a cada 16 ms
+    if (sched.turbo && SDL_GetTicks() - last_present < FRAME_MS) {
+      SDL_Delay(1);
+      continue;
+    }
+    // Com vsync apresenta em todo retraço: a própria apresentação dá o ritmo
+    // desta thread, sem SDL_Delay
+    bool fresh = triple_acquire(&pipeline.frames);
+    if (fresh || repaint || vsync) {
+      const Frame *frame = triple_front(&pipeline.frames);
+      render_frame(&display, &frame->screen);
+      uint64_t presented = SDL_GetPerformanceCounter();
+      last_present = SDL_GetTicks();
+      frame_stats_mark(&present_stats, presented, frequency);
+      // Da leitura da tecla até a apresentação do primeiro frame que a viu
+      if (fresh && frame->input_time != 0) {
+        frame_stats_add(&input_stats,
+                        (presented - frame->input_time) * 1000000 / frequency);
+      }
+      repaint = false;
+    } else {
+      SDL_Delay(1);
+    }
   }
+  pipeline_stop(&pipeline);
+  trace_close(chip.trace);
+  if (frame_stats) {
+    frame_stats_print(&pipeline.pacer.stats, "Emulação", stdout);
+    frame_stats_print(&present_stats, "Apresentação", stdout);
+    frame_stats_print(&input_stats, "Tecla até a tela", stdout);
+    printf("Ressincronizações do relógio: %llu\n",
+           (unsigned long long)pipeline.pacer.resyncs);
+  }
+  if (record_path) {
+    recorder_close(&recorder, chip.cycles);
+  }
+  shutdown_audio(&audio);
+  shutdown_display(&display);
   return 0;
 }
-
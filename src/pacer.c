@@ -0,0 +1,94 @@
+#include "pacer.h"
+#include <stdlib.h>
+#include <string.h>
+
+void frame_stats_init(FrameStats *stats) { memset(stats, 0, sizeof(*stats)); }
+
+void frame_stats_add(FrameStats *stats, uint64_t us) {
+  stats->samples[stats->next] = us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+  stats->next = (stats->next + 1) % FRAME_STATS_SAMPLES;
+  if (stats->count < FRAME_STATS_SAMPLES) {
+    stats->count++;
+  }
+  stats->frames++;
+}
+
+void frame_stats_mark(FrameStats *stats, uint64_t now, uint64_t frequency) {
+  if (stats->last != 0) {
+    frame_stats_add(stats, (now - stats->last) * 1000000 / frequency);
+  }
+  stats->last = now;
+}
+
+void frame_stats_pause(FrameStats *stats) { stats->last = 0; }
+
+static int compare_u32(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+FrameStatsSummary frame_stats_summary(const FrameStats *stats) {
+  FrameStatsSummary summary = {0.0, 0.0, 0.0, stats->frames};
+  if (stats->count == 0) {
+    return summary;
+  }
+  uint32_t sorted[FRAME_STATS_SAMPLES];
+  memcpy(sorted, stats->samples, stats->count * sizeof(uint32_t));
+  qsort(sorted, stats->count, sizeof(uint32_t), compare_u32);
+  summary.p50_ms = sorted[(stats->count - 1) / 2] / 1000.0;
+  summary.p99_ms = sorted[(stats->count - 1) * 99 / 100] / 1000.0;
+  summary.max_ms = sorted[stats->count - 1] / 1000.0;
+  return summary;
+}
+
+void frame_stats_print(const FrameStats *stats, const char *label, FILE *out) {
+  FrameStatsSummary summary = frame_stats_summary(stats);
+  fprintf(out,
+          "%s: %llu frames, p50 %.2f ms, p99 %.2f ms, máx %.2f ms "
+          "(últimos %u)\n",
+          label, (unsigned long long)summary.frames, summary.p50_ms,
+          summary.p99_ms, summary.max_ms, stats->count);
+}
+
+void pacer_init(Pacer *pacer, uint32_t hz) {
+  pacer->frequency = SDL_GetPerformanceFrequency();
+  pacer->hz = hz;
+  pacer->spin = pacer->frequency * PACER_SPIN_US / 1000000;
+  pacer->resyncs = 0;
+  frame_stats_init(&pacer->stats);
+  pacer_reset(pacer);
+}
+
+void pacer_reset(Pacer *pacer) {
+  pacer->epoch = SDL_GetPerformanceCounter();
+  pacer->frame = 0;
+  frame_stats_pause(&pacer->stats);
+}
+
+void pacer_wait(Pacer *pacer, bool turbo) {
+  pacer->frame++;
+  uint64_t now = SDL_GetPerformanceCounter();
+  if (!turbo) {
+    uint64_t deadline =
+        pacer->epoch + pacer->frame * pacer->frequency / pacer->hz;
+    uint64_t max_lag = PACER_MAX_LAG_FRAMES * pacer->frequency / pacer->hz;
+    if (now > deadline + max_lag) {
+      // Atrasado demais (máquina travou, depurador): não tenta recuperar
+      // os frames perdidos de uma vez
+      pacer->epoch = now;
+      pacer->frame = 0;
+      pacer->resyncs++;
+    } else {
+      while (deadline > now + pacer->spin) {
+        uint64_t ms = (deadline - now - pacer->spin) * 1000 / pacer->frequency;
+        SDL_Delay(ms > 0 ? (uint32_t)ms : 1);
+        now = SDL_GetPerformanceCounter();
+      }
+      while (now < deadline) {
+        now = SDL_GetPerformanceCounter();
+      }
+    }
+  }
+  frame_stats_mark(&pacer->stats, now, pacer->frequency);
+}
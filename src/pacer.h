@@ -0,0 +1,55 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define PACER_SPIN_US 2000       // Últimos 2 ms em espera ativa
+#define PACER_MAX_LAG_FRAMES 4   // Mais atrasado que isso: recomeça o relógio
+#define FRAME_STATS_SAMPLES 1024 // Janela dos percentis
+
+// Intervalos entre frames consecutivos, em microssegundos, nos últimos
+// FRAME_STATS_SAMPLES frames. Só a thread dona escreve e lê.
+typedef struct {
+  uint32_t samples[FRAME_STATS_SAMPLES];
+  uint32_t count;
+  uint32_t next;
+  uint64_t last; // Contador do último frame (0 = nenhum ainda)
+  uint64_t frames;
+} FrameStats;
+
+typedef struct {
+  double p50_ms;
+  double p99_ms;
+  double max_ms;
+  uint64_t frames;
+} FrameStatsSummary;
+
+void frame_stats_init(FrameStats *stats);
+void frame_stats_mark(FrameStats *stats, uint64_t now, uint64_t frequency);
+// Amostra avulsa em microssegundos (ex.: latência da entrada até a tela)
+void frame_stats_add(FrameStats *stats, uint64_t us);
+// Recomeça o intervalo sem registrar a pausa (ex.: CPU parada)
+void frame_stats_pause(FrameStats *stats);
+FrameStatsSummary frame_stats_summary(const FrameStats *stats);
+void frame_stats_print(const FrameStats *stats, const char *label, FILE *out);
+
+// Ritmo de frames em tempo absoluto: o prazo do frame n é epoch + n / hz,
+// calculado a partir do início e não somando períodos, então o erro não
+// acumula. Dorme com SDL_Delay até faltar PACER_SPIN_US e termina em espera
+// ativa no contador de alta resolução.
+typedef struct {
+  uint64_t frequency; // Ticks do contador por segundo
+  uint32_t hz;
+  uint64_t epoch;   // Contador no frame 0 da sequência atual
+  uint64_t frame;   // Frames desde epoch
+  uint64_t spin;    // PACER_SPIN_US em ticks
+  uint64_t resyncs; // Vezes que o atraso passou de PACER_MAX_LAG_FRAMES
+  FrameStats stats;
+} Pacer;
+
+void pacer_init(Pacer *pacer, uint32_t hz);
+// Recomeça a contagem a partir de agora (depois de uma pausa)
+void pacer_reset(Pacer *pacer);
+// Espera até o prazo do próximo frame; sem espera em modo turbo
+void pacer_wait(Pacer *pacer, bool turbo);
@@ -0,0 +1,152 @@
+#include "pack.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+uint64_t pack_hash(const uint8_t *data, size_t size) {
+  uint64_t hash = 0xCBF29CE484222325ull;
+  for (size_t n = 0; n < size; n++) {
+    hash ^= data[n];
+    hash *= 0x100000001B3ull;
+  }
+  return hash;
+}
+
+// Mapeia o arquivo inteiro; sem mmap (Windows) lê tudo para a memória
+static const uint8_t *map_file(const char *path, size_t *length) {
+#ifndef _WIN32
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    perror("Erro ao abrir o pacote de ROMs");
+    return NULL;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    fprintf(stderr, "Erro: Pacote de ROMs vazio ou ilegível: %s\n", path);
+    close(fd);
+    return NULL;
+  }
+  void *base = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    perror("Erro ao mapear o pacote de ROMs");
+    return NULL;
+  }
+  *length = (size_t)info.st_size;
+  return (const uint8_t *)base;
+#else
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    perror("Erro ao abrir o pacote de ROMs");
+    return NULL;
+  }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  uint8_t *base = size > 0 ? (uint8_t *)malloc(size) : NULL;
+  if (base == NULL || fread(base, 1, size, file) != (size_t)size) {
+    fprintf(stderr, "Erro: Falha ao ler o pacote de ROMs: %s\n", path);
+    free(base);
+    fclose(file);
+    return NULL;
+  }
+  fclose(file);
+  *length = (size_t)size;
+  return base;
+#endif
+}
+
+static void unmap_file(const uint8_t *base, size_t length) {
+#ifndef _WIN32
+  munmap((void *)base, length);
+#else
+  (void)length;
+  free((void *)base);
+#endif
+}
+
+// O índice é validado uma vez na abertura; depois disso pack_data() não
+// precisa checar limites.
+static bool validate(const RomPack *pack) {
+  const PackEntry *previous = NULL;
+  for (uint32_t n = 0; n < pack->count; n++) {
+    const PackEntry *entry = &pack->entries[n];
+    if (memchr(entry->name, '\0', PACK_NAME_SIZE) == NULL ||
+        entry->offset > pack->length ||
+        entry->size > pack->length - entry->offset) {
+      return false;
+    }
+    if (previous && strcmp(previous->name, entry->name) >= 0) {
+      return false;
+    }
+    previous = entry;
+  }
+  return true;
+}
+
+bool pack_open(RomPack *pack, const char *path) {
+  memset(pack, 0, sizeof(*pack));
+  size_t length = 0;
+  const uint8_t *base = map_file(path, &length);
+  if (base == NULL) {
+    return false;
+  }
+
+  PackHeader header;
+  if (length < sizeof(header)) {
+    fprintf(stderr, "Erro: %s não é um pacote de ROMs.\n", path);
+    unmap_file(base, length);
+    return false;
+  }
+  memcpy(&header, base, sizeof(header));
+  if (header.magic != PACK_MAGIC || header.version != PACK_VERSION ||
+      header.count > (length - sizeof(header)) / sizeof(PackEntry)) {
+    fprintf(stderr, "Erro: %s não é um pacote de ROMs válido.\n", path);
+    unmap_file(base, length);
+    return false;
+  }
+
+  pack->base = base;
+  pack->length = length;
+  pack->entries = (const PackEntry *)(base + sizeof(header));
+  pack->count = header.count;
+  if (!validate(pack)) {
+    fprintf(stderr, "Erro: Índice corrompido no pacote %s.\n", path);
+    pack_close(pack);
+    return false;
+  }
+  return true;
+}
+
+void pack_close(RomPack *pack) {
+  if (pack->base) {
+    unmap_file(pack->base, pack->length);
+  }
+  memset(pack, 0, sizeof(*pack));
+}
+
+const PackEntry *pack_find(const RomPack *pack, const char *name) {
+  // Busca binária: o índice é gravado em ordem de nome
+  uint32_t low = 0;
+  uint32_t high = pack->count;
+  while (low < high) {
+    uint32_t mid = low + (high - low) / 2;
+    int order = strcmp(name, pack->entries[mid].name);
+    if (order == 0) {
+      return &pack->entries[mid];
+    }
+    if (order < 0) {
+      high = mid;
+    } else {
+      low = mid + 1;
+    }
+  }
+  return NULL;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Pacote de ROMs: um único arquivo mapeado somente leitura, com um índice
+// ordenado por nome no início. As instâncias copiam a ROM direto dos bytes
+// mapeados, sem abrir arquivos nem alocar memória por ROM.
+//
+// Layout (little-endian):
+//   PackHeader
+//   PackEntry[count]  (ordenadas por nome)
+//   dados das ROMs
+#define PACK_MAGIC 0x4B503843u // "C8PK"
+#define PACK_VERSION 1
+#define PACK_NAME_SIZE 48
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t reserved;
+  uint32_t count;
+  uint32_t padding;
+} PackHeader;
+
+typedef struct {
+  char name[PACK_NAME_SIZE]; // Terminado em '\0'
+  uint64_t hash;             // FNV-1a de 64 bits do conteúdo
+  uint32_t offset;           // A partir do início do arquivo
+  uint32_t size;
+} PackEntry;
+
+typedef struct {
+  const uint8_t *base;
+  size_t length;
+  const PackEntry *entries;
+  uint32_t count;
+} RomPack;
+
+bool pack_open(RomPack *pack, const char *path);
+void pack_close(RomPack *pack);
+const PackEntry *pack_find(const RomPack *pack, const char *name);
+uint64_t pack_hash(const uint8_t *data, size_t size);
+
+static inline const uint8_t *pack_data(const RomPack *pack,
+                                       const PackEntry *entry) {
+  return pack->base + entry->offset;
+}
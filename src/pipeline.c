@@ -0,0 +1,267 @@
+#include "pipeline.h"
+#include "idle.h"
+#include <stdio.h>
+#include <string.h>
+
+static void apply_key(Pipeline *pipeline, const KeyEvent *event) {
+  CPU *chip = pipeline->chip;
+  chip->keys[event->key] = event->down;
+  if (pipeline->recorder) {
+    recorder_key(pipeline->recorder, chip->cycles, event->key, event->down);
+  }
+  if (pipeline->input_time == 0 || event->time < pipeline->input_time) {
+    pipeline->input_time = event->time;
+  }
+}
+
+// Aplica as teclas cujo ciclo já chegou
+static void apply_due_keys(Pipeline *pipeline) {
+  size_t due = 0;
+  while (due < pipeline->pending_count &&
+         pipeline->pending[due].cycle <= pipeline->chip->cycles) {
+    apply_key(pipeline, &pipeline->pending[due++]);
+  }
+  memmove(pipeline->pending, &pipeline->pending[due],
+          (pipeline->pending_count - due) * sizeof(KeyEvent));
+  pipeline->pending_count -= due;
+}
+
+// O tempo do convidado pulou (estado restaurado, rewind): os ciclos
+// agendados não valem mais, então aplica tudo agora
+static void flush_keys(Pipeline *pipeline) {
+  for (size_t n = 0; n < pipeline->pending_count; n++) {
+    apply_key(pipeline, &pipeline->pending[n]);
+  }
+  pipeline->pending_count = 0;
+  memset(pipeline->press_cycle, 0, sizeof(pipeline->press_cycle));
+  memset(pipeline->key_cycle, 0, sizeof(pipeline->key_cycle));
+}
+
+// Ciclo do frame atual para um evento que chegou em time: a mesma posição
+// que ele ocupa no intervalo entre o início do frame anterior e o deste
+static uint64_t arrival_cycle(const Pipeline *pipeline, uint64_t time) {
+  const CPU *chip = pipeline->chip;
+  uint32_t per_frame = pipeline->sched->cycles_per_frame;
+  uint64_t frame = per_frame - chip->cycles % per_frame;
+  uint64_t start = pipeline->last_frame_time;
+  if (start == 0 || time <= start || pipeline->frame_time <= start) {
+    return chip->cycles; // Sem frame anterior (início, CPU dormindo)
+  }
+  uint64_t offset = (time - start) * frame / (pipeline->frame_time - start);
+  return chip->cycles + (offset < frame ? offset : frame - 1);
+}
+
+static void schedule_key(Pipeline *pipeline, const InputMessage *message) {
+  uint8_t key = message->key;
+  uint64_t cycle = arrival_cycle(pipeline, message->time);
+  // Eventos da mesma tecla nunca trocam de ordem
+  if (cycle < pipeline->key_cycle[key]) {
+    cycle = pipeline->key_cycle[key];
+  }
+  if (message->down) {
+    pipeline->press_cycle[key] = cycle;
+  } else if (cycle < pipeline->press_cycle[key] +
+                         pipeline->sched->cycles_per_frame) {
+    // Toque rápido: a tecla fica apertada por um frame inteiro
+    cycle = pipeline->press_cycle[key] + pipeline->sched->cycles_per_frame;
+  }
+  pipeline->key_cycle[key] = cycle;
+
+  if (pipeline->pending_count == INPUT_QUEUE_CAPACITY) {
+    // Sem espaço: o evento mais antigo entra agora
+    apply_key(pipeline, &pipeline->pending[0]);
+    memmove(pipeline->pending, &pipeline->pending[1],
+            (--pipeline->pending_count) * sizeof(KeyEvent));
+  }
+  // Inserção ordenada; no mesmo ciclo vale a ordem de chegada
+  size_t at = pipeline->pending_count;
+  while (at > 0 && pipeline->pending[at - 1].cycle > cycle) {
+    pipeline->pending[at] = pipeline->pending[at - 1];
+    at--;
+  }
+  pipeline->pending[at] =
+      (KeyEvent){cycle, message->time, key, message->down};
+  pipeline->pending_count++;
+}
+
+static void drain_input(Pipeline *pipeline) {
+  CPU *chip = pipeline->chip;
+  InputMessage message;
+  while (spsc_pop(&pipeline->input, &message)) {
+    switch (message.command) {
+    case PIPELINE_KEY:
+      if (pipeline->replay) {
+        break; // A entrada vem da gravação
+      }
+      schedule_key(pipeline, &message);
+      break;
+    case PIPELINE_SAVE:
+      save_state(chip, &pipeline->slot);
+      pipeline->has_slot = true;
+      break;
+    case PIPELINE_LOAD:
+      if (pipeline->recorder || pipeline->replay) {
+        break;
+      }
+      if (pipeline->has_slot && load_state(chip, &pipeline->slot)) {
+        // O histórico não leva de volta a partir do estado restaurado
+        rewind_reset(&pipeline->rewind);
+        flush_keys(pipeline);
+      }
+      break;
+    case PIPELINE_REWIND:
+      pipeline->rewinding =
+          message.down && !pipeline->recorder && !pipeline->replay;
+      break;
+    }
+  }
+}
+
+// Um frame com as teclas entrando nos ciclos agendados
+static void run_input_frame(Pipeline *pipeline) {
+  CPU *chip = pipeline->chip;
+  const Scheduler *sched = pipeline->sched;
+  uint64_t end = chip->cycles + sched->cycles_per_frame -
+                 chip->cycles % sched->cycles_per_frame;
+  while (chip->cycles < end) {
+    apply_due_keys(pipeline);
+    uint64_t until = end;
+    if (pipeline->pending_count > 0 && pipeline->pending[0].cycle < until) {
+      until = pipeline->pending[0].cycle;
+    }
+    run_cycles(chip, sched, until - chip->cycles);
+  }
+}
+
+static void publish_frame(Pipeline *pipeline, uint64_t number) {
+  Frame *frame = triple_back(&pipeline->frames);
+  frame->screen = pipeline->chip->screen;
+  frame->number = number;
+  frame->input_time = pipeline->input_time;
+  triple_publish(&pipeline->frames);
+}
+
+static int emulation_thread(void *arg) {
+  Pipeline *pipeline = (Pipeline *)arg;
+  CPU *chip = pipeline->chip;
+  const Scheduler *sched = pipeline->sched;
+
+  Pacer *pacer = &pipeline->pacer;
+  pacer_init(pacer, TIMER_HZ);
+  uint64_t number = 0;
+
+  while (atomic_load_explicit(&pipeline->running, memory_order_relaxed)) {
+    pipeline->last_frame_time = pipeline->frame_time;
+    pipeline->frame_time = SDL_GetPerformanceCounter();
+    drain_input(pipeline);
+    if (pipeline->rewinding && pipeline->rewind.buffer) {
+      if (rewind_step_back(&pipeline->rewind, chip)) {
+        flush_keys(pipeline); // Voltou no tempo
+      }
+    } else {
+      if (pipeline->replay) {
+        replay_run(pipeline->replay, chip, sched,
+                   sched->cycles_per_frame -
+                       chip->cycles % sched->cycles_per_frame);
+      } else {
+        run_input_frame(pipeline);
+      }
+      if (pipeline->rewind.buffer) {
+        rewind_push(&pipeline->rewind, chip);
+      }
+    }
+    audio_update(pipeline->audio, chip, sched->cycles_per_frame);
+    number++;
+
+    // Frames sem desenho não mostram a tecla: o carimbo espera o próximo
+    // frame publicado
+    if (chip->draw_flag) {
+      publish_frame(pipeline, number);
+      chip->draw_flag = false;
+      pipeline->input_time = 0;
+    }
+
+    // CPU parada esperando tecla, sem timers correndo: os próximos frames
+    // seriam todos iguais, então dorme até chegar uma mensagem. Na
+    // reprodução as teclas vêm da gravação e a execução segue normal.
+    if (!pipeline->replay && !pipeline->rewinding &&
+        pipeline->pending_count == 0 && idle_halted(chip)) {
+      SDL_SemWaitTimeout(pipeline->wake, IDLE_WAIT_MS);
+      pacer_reset(pacer);
+      // A tecla que acordou a CPU entra no início do próximo frame
+      pipeline->frame_time = 0;
+      continue;
+    }
+
+    pacer_wait(pacer, sched->turbo);
+    if (pipeline->print_stats && number % PIPELINE_STATS_FRAMES == 0) {
+      frame_stats_print(&pacer->stats, "Emulação", stdout);
+    }
+  }
+  return 0;
+}
+
+bool pipeline_start(Pipeline *pipeline, CPU *chip, const Scheduler *sched,
+                    Audio *audio) {
+  pipeline->chip = chip;
+  pipeline->sched = sched;
+  pipeline->audio = audio;
+  triple_init(&pipeline->frames);
+  spsc_init(&pipeline->input, pipeline->input_storage, INPUT_QUEUE_CAPACITY,
+            sizeof(InputMessage));
+  pipeline->has_slot = false;
+  pipeline->rewinding = false;
+  pipeline->pending_count = 0;
+  memset(pipeline->press_cycle, 0, sizeof(pipeline->press_cycle));
+  memset(pipeline->key_cycle, 0, sizeof(pipeline->key_cycle));
+  pipeline->frame_time = 0;
+  pipeline->input_time = 0;
+  pipeline->wake = SDL_CreateSemaphore(0);
+  if (pipeline->wake == NULL) {
+    printf("Erro ao criar o semáforo da emulação: %s\n", SDL_GetError());
+    return false;
+  }
+  // Sem memória para o histórico o emulador continua, só sem rewind
+  rewind_init(&pipeline->rewind, REWIND_DEFAULT_BYTES);
+  atomic_init(&pipeline->running, true);
+
+  pipeline->thread = SDL_CreateThread(emulation_thread, "emulation", pipeline);
+  if (pipeline->thread == NULL) {
+    printf("Erro ao criar a thread de emulação: %s\n", SDL_GetError());
+    return false;
+  }
+  return true;
+}
+
+void pipeline_stop(Pipeline *pipeline) {
+  if (pipeline->thread) {
+    atomic_store(&pipeline->running, false);
+    SDL_SemPost(pipeline->wake);
+    SDL_WaitThread(pipeline->thread, NULL);
+    pipeline->thread = NULL;
+  }
+  if (pipeline->wake) {
+    SDL_DestroySemaphore(pipeline->wake);
+    pipeline->wake = NULL;
+  }
+  rewind_free(&pipeline->rewind);
+}
+
+bool pipeline_send_key(Pipeline *pipeline, uint8_t key, bool down) {
+  InputMessage message = {SDL_GetPerformanceCounter(), PIPELINE_KEY, key,
+                          down};
+  if (!spsc_push(&pipeline->input, &message)) {
+    return false;
+  }
+  SDL_SemPost(pipeline->wake);
+  return true;
+}
+
+bool pipeline_send_command(Pipeline *pipeline, uint8_t command, bool down) {
+  InputMessage message = {SDL_GetPerformanceCounter(), command, 0, down};
+  if (!spsc_push(&pipeline->input, &message)) {
+    return false;
+  }
+  SDL_SemPost(pipeline->wake);
+  return true;
+}
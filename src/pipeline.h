@@ -0,0 +1,92 @@
+#pragma once
+
+#include "audio.h"
+#include "cpu.h"
+#include "pacer.h"
+#include "replay.h"
+#include "rewind.h"
+#include "sched.h"
+#include "spsc.h"
+#include "triple.h"
+#include <SDL2/SDL.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#define INPUT_QUEUE_CAPACITY 256 // Potência de 2
+#define IDLE_WAIT_MS 100          // Espera máxima com a CPU parada
+#define PIPELINE_STATS_FRAMES 300 // 5 s
+
+enum {
+  PIPELINE_KEY,    // Tecla do Chip-8
+  PIPELINE_SAVE,   // Salva o estado no slot em memória
+  PIPELINE_LOAD,   // Restaura o slot
+  PIPELINE_REWIND, // Enquanto down, volta um frame por frame
+};
+
+typedef struct {
+  uint64_t time; // Contador de alta resolução na chegada do evento
+  uint8_t command;
+  uint8_t key;
+  uint8_t down;
+} InputMessage;
+
+// Tecla agendada para um ciclo do convidado
+typedef struct {
+  uint64_t cycle;
+  uint64_t time; // Chegada (InputMessage.time)
+  uint8_t key;
+  uint8_t down;
+} KeyEvent;
+
+// Emulação em uma thread própria. Ela publica frames completos no buffer
+// triplo e recebe teclas por uma fila SPSC; a thread principal só trata
+// eventos do SDL e apresenta o frame mais recente, então apresentações
+// lentas ou vsync nunca atrasam o convidado.
+//
+// Cada tecla chega com o instante em que foi lida e é aplicada no ciclo
+// correspondente do frame seguinte: um evento que chegou no meio do
+// intervalo entre dois frames entra no meio do próximo, então a ordem e o
+// espaçamento entre teclas são preservados em vez de todas caírem na
+// fronteira do frame. Uma tecla solta menos de um frame depois de apertada
+// continua apertada até completar um frame do convidado, para EX9E e FX0A
+// verem toques rápidos.
+typedef struct {
+  CPU *chip;
+  const Scheduler *sched;
+  Audio *audio;
+
+  TripleBuffer frames;
+  SpscRing input;
+  InputMessage input_storage[INPUT_QUEUE_CAPACITY];
+  SDL_sem *wake; // Sinalizado a cada mensagem; acorda a CPU parada
+
+  // Só a thread de emulação mexe nestes campos (pacer pode ser lido depois
+  // de pipeline_stop)
+  Pacer pacer;
+  bool print_stats; // Imprime os tempos de frame a cada PIPELINE_STATS_FRAMES
+  SaveState slot;
+  bool has_slot;
+  Rewind rewind;
+  bool rewinding;
+  KeyEvent pending[INPUT_QUEUE_CAPACITY]; // Ordenadas por ciclo
+  size_t pending_count;
+  uint64_t press_cycle[KEYS]; // Ciclo do último aperto de cada tecla
+  uint64_t key_cycle[KEYS];   // Ciclo do último evento agendado da tecla
+  uint64_t frame_time;        // Início do frame atual e do anterior
+  uint64_t last_frame_time;
+  uint64_t input_time; // Chegada da tecla mais antiga ainda não publicada
+
+  // Opcionais, definidos antes de pipeline_start(). Durante a gravação ou a
+  // reprodução load e rewind ficam desativados para não quebrar o sincronismo.
+  Recorder *recorder;
+  Replay *replay;
+
+  atomic_bool running;
+  SDL_Thread *thread;
+} Pipeline;
+
+bool pipeline_start(Pipeline *pipeline, CPU *chip, const Scheduler *sched,
+                    Audio *audio);
+void pipeline_stop(Pipeline *pipeline);
+bool pipeline_send_key(Pipeline *pipeline, uint8_t key, bool down);
+bool pipeline_send_command(Pipeline *pipeline, uint8_t command, bool down);
@@ -0,0 +1,243 @@
+#include "profile.h"
+
+#ifdef PROFILE_MODE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PROFILE_TABLE_SIZE (PROFILE_MAX_NODES * 2) // Potência de 2
+#define PROFILE_TOP 32
+
+// Nó da árvore de contextos: o caminho da raiz até ele é a sequência de
+// sites de chamada (endereço do 2NNN) presentes na pilha.
+typedef struct {
+  uint16_t parent;
+  uint16_t site;
+  uint64_t cycles; // Instruções executadas neste contexto (exclusivo)
+} ProfileNode;
+
+struct Profile {
+  uint64_t total;
+  uint64_t op_counts[OP_COUNT];
+  uint64_t pc_hits[MEMORY_SIZE];
+  ProfileNode nodes[PROFILE_MAX_NODES]; // nodes[0] = raiz
+  uint16_t node_count;
+  uint16_t table[PROFILE_TABLE_SIZE]; // (pai, site) -> nó; 0 = vazio
+  uint16_t current;
+  bool truncated;
+};
+typedef struct Profile Profile;
+
+// Posição de um contador na ordenação dos relatórios
+typedef struct {
+  uint64_t value;
+  uint16_t index;
+} Ranked;
+
+static const char *const op_names[OP_COUNT] = {
+    [OP_UNDECODED] = "?",     [OP_NOP] = "0NNN",      [OP_CLS] = "00E0",
+    [OP_RET] = "00EE",        [OP_JP] = "1NNN",       [OP_CALL] = "2NNN",
+    [OP_SE_IMM] = "3XNN",     [OP_SNE_IMM] = "4XNN",  [OP_SE_REG] = "5XY0",
+    [OP_LD_IMM] = "6XNN",     [OP_ADD_IMM] = "7XNN",  [OP_LD_REG] = "8XY0",
+    [OP_OR] = "8XY1",         [OP_AND] = "8XY2",      [OP_XOR] = "8XY3",
+    [OP_ADD_REG] = "8XY4",    [OP_SUB] = "8XY5",      [OP_SHR] = "8XY6",
+    [OP_SUBN] = "8XY7",       [OP_SHL] = "8XYE",      [OP_SKIP_XOR] = "9090",
+    [OP_LD_I] = "ANNN",       [OP_JP_V0] = "BNNN",    [OP_RND] = "CXNN",
+    [OP_DRW] = "DXYN",        [OP_SKP] = "EX9E",      [OP_SKNP] = "EXA1",
+    [OP_LD_VX_DT] = "FX07",   [OP_LD_K] = "F20A",     [OP_LD_DT] = "FX15",
+    [OP_LD_ST] = "F018",      [OP_ADD_I] = "FX1E",    [OP_ST_VX] = "FX20",
+    [OP_LD_F] = "F129",       [OP_LD_HF] = "F229",    [OP_BCD] = "FE33",
+    [OP_ST_REGS] = "FX55",    [OP_LD_REGS] = "FX65",  [OP_NOT] = "FX90",
+    [OP_SCD] = "00CN",        [OP_SCR] = "00FB",      [OP_SCL] = "00FC",
+    [OP_EXIT] = "00FD",       [OP_LOW] = "00FE",      [OP_HIGH] = "00FF",
+    [OP_ST_RPL] = "FX75",     [OP_LD_RPL] = "FX85",   [OP_SCU] = "00DN",
+    [OP_ST_RANGE] = "5XY2",   [OP_LD_RANGE] = "5XY3", [OP_LD_LONG] = "F000",
+    [OP_PLANE] = "FN01",      [OP_AUDIO] = "F002",    [OP_PITCH] = "FX3A",
+    [OP_UNKNOWN] = "desconhecido",
+};
+
+struct Profile *profile_create(void) {
+  Profile *profile = (Profile *)calloc(1, sizeof(Profile));
+  if (profile == NULL) {
+    fprintf(stderr, "Erro: Falha ao alocar memória para o profiler.\n");
+    return NULL;
+  }
+  profile->node_count = 1; // nodes[0] = raiz
+  return profile;
+}
+
+void profile_free(struct Profile *profile) { free(profile); }
+
+static uint16_t child_node(Profile *profile, uint16_t parent, uint16_t site) {
+  uint32_t key = ((uint32_t)parent << 16) | site;
+  uint32_t slot = (key * 2654435761u) & (PROFILE_TABLE_SIZE - 1);
+  for (;;) {
+    uint16_t index = profile->table[slot];
+    if (index == 0) {
+      break;
+    }
+    if (profile->nodes[index].parent == parent &&
+        profile->nodes[index].site == site) {
+      return index;
+    }
+    slot = (slot + 1) & (PROFILE_TABLE_SIZE - 1);
+  }
+
+  // Sem espaço: os ciclos ficam no contexto do chamador
+  if (profile->node_count == PROFILE_MAX_NODES) {
+    profile->truncated = true;
+    return parent;
+  }
+  uint16_t index = profile->node_count++;
+  profile->nodes[index] = (ProfileNode){parent, site, 0};
+  profile->table[slot] = index;
+  return index;
+}
+
+// Reconstrói o contexto a partir da pilha do convidado. Roda só em CALL e
+// RET, então programas que mexem no SP de outro jeito também ficam certos.
+static void sync_context(Profile *profile, const CPU *chip) {
+  uint16_t node = 0;
+  int depth = chip->sp < STACK_SIZE ? chip->sp : STACK_SIZE;
+  for (int level = 0; level < depth; level++) {
+    node = child_node(profile, node, dram_addr(chip->stack[level] - 2));
+  }
+  profile->current = node;
+}
+
+void profile_op(struct Profile *profile, const CPU *chip, const DecodedOp *op,
+                uint16_t pc) {
+  profile->total++;
+  profile->op_counts[op->handler]++;
+  profile->pc_hits[dram_addr(pc)]++;
+  // A própria instrução de CALL/RET conta no contexto em que começou
+  profile->nodes[profile->current].cycles++;
+  if (op->handler == OP_CALL || op->handler == OP_RET) {
+    sync_context(profile, chip);
+  }
+}
+
+// Maior primeiro; empates pelo menor índice
+static int compare_ranked(const void *a, const void *b) {
+  const Ranked *x = (const Ranked *)a;
+  const Ranked *y = (const Ranked *)b;
+  if (x->value != y->value) {
+    return x->value < y->value ? 1 : -1;
+  }
+  return (x->index > y->index) - (x->index < y->index);
+}
+
+static void rank(Ranked *order, const uint64_t *values, int count) {
+  for (int n = 0; n < count; n++) {
+    order[n] = (Ranked){values[n], (uint16_t)n};
+  }
+  qsort(order, count, sizeof(order[0]), compare_ranked);
+}
+
+static double percent(const Profile *profile, uint64_t part) {
+  return profile->total ? 100.0 * part / profile->total : 0.0;
+}
+
+static void write_folded(const Profile *profile, FILE *out) {
+  for (uint16_t n = 0; n < profile->node_count; n++) {
+    const ProfileNode *node = &profile->nodes[n];
+    if (node->cycles == 0) {
+      continue;
+    }
+    uint16_t path[STACK_SIZE + 1];
+    int depth = 0;
+    for (uint16_t at = n; at != 0; at = profile->nodes[at].parent) {
+      path[depth++] = profile->nodes[at].site;
+    }
+    fprintf(out, "rom");
+    while (depth > 0) {
+      fprintf(out, ";call@0x%03X", path[--depth]);
+    }
+    fprintf(out, " %llu\n", (unsigned long long)node->cycles);
+  }
+}
+
+// order e inclusive: MEMORY_SIZE entradas cada, fornecidas por quem chama
+static void write_report(const Profile *profile, FILE *out, Ranked *order,
+                         uint64_t *inclusive) {
+  fprintf(out, "Instruções executadas: %llu\n",
+          (unsigned long long)profile->total);
+  if (profile->truncated) {
+    fprintf(out, "Aviso: mais de %d contextos de chamada; os excedentes "
+                 "foram somados ao chamador.\n",
+            PROFILE_MAX_NODES);
+  }
+
+  fprintf(out, "\nPor instrução:\n");
+  rank(order, profile->op_counts, OP_COUNT);
+  for (int n = 0; n < OP_COUNT && order[n].value; n++) {
+    fprintf(out, "  %-12s %14llu  %6.2f%%\n", op_names[order[n].index],
+            (unsigned long long)order[n].value,
+            percent(profile, order[n].value));
+  }
+
+  fprintf(out, "\nEndereços mais executados:\n");
+  rank(order, profile->pc_hits, MEMORY_SIZE);
+  for (int n = 0; n < PROFILE_TOP && order[n].value; n++) {
+    fprintf(out, "  0x%03X %14llu  %6.2f%%\n", order[n].index,
+            (unsigned long long)order[n].value,
+            percent(profile, order[n].value));
+  }
+
+  // Ciclos inclusivos por site: cada nó soma nos sites do seu caminho, uma
+  // vez por site mesmo com recursão
+  memset(inclusive, 0, MEMORY_SIZE * sizeof(inclusive[0]));
+  for (uint16_t n = 1; n < profile->node_count; n++) {
+    uint16_t seen[STACK_SIZE + 1];
+    int seen_count = 0;
+    for (uint16_t at = n; at != 0; at = profile->nodes[at].parent) {
+      uint16_t site = profile->nodes[at].site;
+      bool repeated = false;
+      for (int s = 0; s < seen_count; s++) {
+        repeated |= seen[s] == site;
+      }
+      if (!repeated) {
+        seen[seen_count++] = site;
+        inclusive[site] += profile->nodes[n].cycles;
+      }
+    }
+  }
+  fprintf(out, "\nChamadas (2NNN), ciclos inclusivos:\n");
+  fprintf(out, "  site   %14s %14s\n", "chamadas", "ciclos");
+  rank(order, inclusive, MEMORY_SIZE);
+  for (int n = 0; n < MEMORY_SIZE && order[n].value; n++) {
+    fprintf(out, "  0x%03X  %14llu %14llu  %6.2f%%\n", order[n].index,
+            (unsigned long long)profile->pc_hits[order[n].index],
+            (unsigned long long)order[n].value,
+            percent(profile, order[n].value));
+  }
+}
+
+bool profile_write_report(const struct Profile *profile) {
+  Ranked *order = (Ranked *)malloc(MEMORY_SIZE * sizeof(Ranked));
+  uint64_t *inclusive = (uint64_t *)malloc(MEMORY_SIZE * sizeof(uint64_t));
+  FILE *out = order && inclusive ? fopen(PROFILE_REPORT_PATH, "w") : NULL;
+  if (out == NULL) {
+    perror("Erro ao criar o relatório do profiler");
+    free(order);
+    free(inclusive);
+    return false;
+  }
+  write_report(profile, out, order, inclusive);
+  fclose(out);
+  free(order);
+  free(inclusive);
+
+  out = fopen(PROFILE_FOLDED_PATH, "w");
+  if (out == NULL) {
+    perror("Erro ao criar o arquivo de pilhas do profiler");
+    return false;
+  }
+  write_folded(profile, out);
+  fclose(out);
+  fprintf(stderr, "Perfil gravado em %s e %s.\n", PROFILE_REPORT_PATH,
+          PROFILE_FOLDED_PATH);
+  return true;
+}
+
+#endif
@@ -0,0 +1,24 @@
+#pragma once
+#include "cpu.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Profiler do programa convidado, ativado com -DPROFILE_MODE=ON no CMake.
+// Conta execuções por handler e por endereço e atribui ciclos às chamadas
+// 2NNN ativas na pilha. Cada CPU tem o seu perfil (chip->profile, NULL =
+// desligado), então instâncias em threads diferentes não se misturam. Sem
+// PROFILE_MODE o gancho some e o laço do interpretador fica igual.
+#define PROFILE_REPORT_PATH "chip8-profile.txt"
+#define PROFILE_FOLDED_PATH "chip8-profile.folded" // Para flamegraph.pl
+#define PROFILE_MAX_NODES 4096 // Contextos de chamada distintos
+
+#ifdef PROFILE_MODE
+
+struct Profile *profile_create(void);
+void profile_free(struct Profile *profile);
+void profile_op(struct Profile *profile, const CPU *chip, const DecodedOp *op,
+                uint16_t pc);
+// Grava PROFILE_REPORT_PATH e PROFILE_FOLDED_PATH
+bool profile_write_report(const struct Profile *profile);
+
+#endif
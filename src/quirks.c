@@ -0,0 +1,23 @@
+#include "quirks.h"
+#include <string.h>
+
+static const char *const names[QUIRKS_COUNT] = {
+    [QUIRKS_LEGACY] = "legacy",
+    [QUIRKS_VIP] = "vip",
+    [QUIRKS_CHIP48] = "chip48",
+    [QUIRKS_SCHIP] = "schip",
+    [QUIRKS_XOCHIP] = "xochip",
+};
+
+const char *quirks_name(uint8_t quirks) {
+  return quirks < QUIRKS_COUNT ? names[quirks] : "?";
+}
+
+int quirks_from_name(const char *name) {
+  for (int q = 0; q < QUIRKS_COUNT; q++) {
+    if (strcmp(name, names[q]) == 0) {
+      return q;
+    }
+  }
+  return -1;
+}
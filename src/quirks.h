@@ -0,0 +1,43 @@
+#pragma once
+#include <stdint.h>
+
+// Perfis de compatibilidade. Cada perfil vira um interpretador próprio em
+// emu.c (as macros abaixo são constantes dentro dele), então o laço quente
+// não testa nenhuma flag; o perfil é escolhido uma vez ao carregar a ROM.
+enum {
+  QUIRKS_LEGACY = 0, // Comportamento original deste emulador
+  QUIRKS_VIP,        // COSMAC VIP
+  QUIRKS_CHIP48,     // CHIP-48 (HP 48)
+  QUIRKS_SCHIP,      // SUPER-CHIP 1.1
+  QUIRKS_XOCHIP,     // XO-CHIP (Octo)
+  QUIRKS_COUNT
+};
+
+// 8XY6/8XYE: VX = VY deslocado (VIP) em vez de VX deslocado no lugar
+#define QUIRK_SHIFT_VY(p) ((p) == QUIRKS_VIP || (p) == QUIRKS_XOCHIP)
+// 8XY4..8XYE gravam VF depois do resultado (com X = F, VF fica com a flag)
+#define QUIRK_FLAG_LAST(p) ((p) != QUIRKS_LEGACY)
+// 8XY1/8XY2/8XY3 zeram VF
+#define QUIRK_LOGIC_VF(p) ((p) == QUIRKS_VIP)
+// FX55/FX65 avançam I: VIP e XO-CHIP somam X + 1, CHIP-48 soma X, os outros
+// não mudam I
+#define QUIRK_I_STEP(p, x)                                                    \
+  ((p) == QUIRKS_VIP || (p) == QUIRKS_XOCHIP ? (x) + 1                        \
+   : (p) == QUIRKS_CHIP48                    ? (x)                            \
+                                             : 0)
+// BNNN vira BXNN: salta para XNN + VX
+#define QUIRK_JUMP_VX(p) ((p) == QUIRKS_CHIP48 || (p) == QUIRKS_SCHIP)
+// Decodificação padrão (FX0A, FX18, FX29, FX33 para qualquer X, 9XY0). O
+// perfil legado só reconhece as variações exatas (F20A, F018, F129, FE33) e
+// as extensões 9090, FX20, F229 e FX90.
+#define QUIRK_STANDARD_DECODE(p) ((p) != QUIRKS_LEGACY)
+// SUPER-CHIP: 128x64 (00FE/00FF), rolagem (00CN, 00FB, 00FC), sprites 16x16
+// (DXY0), dígitos grandes (FX30), flags do usuário (FX75/FX85) e 00FD
+#define QUIRK_HIRES(p) ((p) == QUIRKS_SCHIP || (p) == QUIRKS_XOCHIP)
+// XO-CHIP: dois planos (FN01), 00DN, 5XY2/5XY3, F000 NNNN (os saltos pulam
+// os 4 bytes dela), padrões de áudio (F002, FX3A) e sprites que dão a volta
+// nas bordas em vez de serem cortados
+#define QUIRK_XO(p) ((p) == QUIRKS_XOCHIP)
+
+const char *quirks_name(uint8_t quirks);
+int quirks_from_name(const char *name); // -1 se desconhecido
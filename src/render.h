@@ -2,34 +2,29 @@
 
 #include <SDL2/SDL.h>
 #include <stdbool.h>
-#define SCREEN_WIDTH 64
-#define SCREEN_HEIGHT 32
-#define PIXEL_SIZE 10
+#define WINDOW_SCALE 10 // Tamanho inicial da janela: 640x320
 #include "cpu.h"
+#include "framebuffer.h"
+#include "upscale.h"
 #include <stdbool.h>
 
-static int16_t audio_buffer[AUDIO_BUFFER_SIZE];
-static int audio_buffer_position = 0;
-static int audio_phase = 0;
-static bool audio_initialized = false;
-
 typedef struct {
   SDL_Window *window;
   SDL_Renderer *renderer;
+  SDL_Texture *texture; // Já no tamanho final, gerada pelo filtro na CPU
+  int texture_width;
+  int texture_height;
+  Upscaler upscaler;
 } Display;
-typedef struct {
-  CPU *chip;
-  Display *display;
-} ThreadArgs;
 
-bool initialize_display(Display *display);
+// Com vsync SDL_RenderPresent espera o retraço vertical do monitor. filter
+// é um UPSCALE_*; a janela pode ser redimensionada e a imagem acompanha.
+bool initialize_display(Display *display, bool vsync, int filter);
+// A janela mudou de tamanho: recalcula o fator do filtro. false se o filtro
+// continuou com o tamanho anterior.
+bool resize_display(Display *display);
+void render_frame(Display *display, const Screen *screen);
 void render_screen(struct Chip8 *chip8, Display *display);
 void shutdown_display(Display *display);
-void processInput(struct Chip8 *chip, SDL_Event *event);
-void play_sound(int frequency, int duration_ms);
-void handle_audio(CPU *chip);
-void audio_callback(void *userdata, uint8_t *stream, int len);
-void init_audio(CPU *chip);
-void *audio_thread(void *arg);
-
-void *video_thread(void *arg);
\ No newline at end of file
+int chip8_key(SDL_Keycode sym);
+void processInput(struct Chip8 *chip, SDL_Event *event);
\ No newline at end of file
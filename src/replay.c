@@ -0,0 +1,132 @@
+#include "replay.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool recorder_open(Recorder *recorder, const char *path, const CPU *chip,
+                   const Scheduler *sched, uint64_t rom_hash) {
+  recorder->file = fopen(path, "wb");
+  if (recorder->file == NULL) {
+    perror("Erro ao criar a gravação");
+    return false;
+  }
+  memset(&recorder->header, 0, sizeof(recorder->header));
+  recorder->header.magic = REPLAY_MAGIC;
+  recorder->header.version = REPLAY_VERSION;
+  recorder->header.quirks = chip->quirks;
+  recorder->header.seed = chip->rng_state;
+  recorder->header.cycles_per_frame = sched->cycles_per_frame;
+  recorder->header.rom_hash = rom_hash;
+  recorder->last_cycle = chip->cycles;
+  // Contagem e duração são regravadas no fechamento
+  fwrite(&recorder->header, sizeof(recorder->header), 1, recorder->file);
+  return true;
+}
+
+void recorder_key(Recorder *recorder, uint64_t cycle, uint8_t key, bool down) {
+  uint8_t bytes[11];
+  size_t length = 0;
+  uint64_t delta = cycle - recorder->last_cycle;
+  do {
+    bytes[length] = delta & 0x7F;
+    delta >>= 7;
+    bytes[length++] |= delta ? 0x80 : 0;
+  } while (delta);
+  bytes[length++] = (key & 0x0F) | (down ? 0x80 : 0);
+  fwrite(bytes, 1, length, recorder->file);
+  recorder->last_cycle = cycle;
+  recorder->header.event_count++;
+}
+
+void recorder_close(Recorder *recorder, uint64_t end_cycle) {
+  if (recorder->file == NULL) {
+    return;
+  }
+  recorder->header.end_cycle = end_cycle;
+  fseek(recorder->file, 0, SEEK_SET);
+  fwrite(&recorder->header, sizeof(recorder->header), 1, recorder->file);
+  if (fclose(recorder->file) != 0) {
+    perror("Erro ao gravar a sessão");
+  }
+  recorder->file = NULL;
+}
+
+static bool read_varint(FILE *file, uint64_t *value) {
+  *value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    int byte = fgetc(file);
+    if (byte == EOF) {
+      return false;
+    }
+    *value |= (uint64_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool replay_load(Replay *replay, const char *path) {
+  memset(replay, 0, sizeof(*replay));
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    perror("Erro ao abrir a gravação");
+    return false;
+  }
+  if (fread(&replay->header, sizeof(replay->header), 1, file) != 1 ||
+      replay->header.magic != REPLAY_MAGIC ||
+      replay->header.version != REPLAY_VERSION) {
+    fprintf(stderr, "Erro: %s não é uma gravação válida.\n", path);
+    fclose(file);
+    return false;
+  }
+
+  uint32_t count = replay->header.event_count;
+  replay->events = (ReplayEvent *)malloc((count ? count : 1) *
+                                         sizeof(ReplayEvent));
+  if (replay->events == NULL) {
+    fprintf(stderr, "Erro: Falha ao alocar memória para a gravação.\n");
+    fclose(file);
+    return false;
+  }
+  uint64_t cycle = 0;
+  for (uint32_t n = 0; n < count; n++) {
+    uint64_t delta;
+    int key = EOF;
+    if (!read_varint(file, &delta) || (key = fgetc(file)) == EOF) {
+      fprintf(stderr, "Erro: Gravação truncada em %s.\n", path);
+      replay_free(replay);
+      fclose(file);
+      return false;
+    }
+    cycle += delta;
+    replay->events[n] = (ReplayEvent){cycle, key & 0x0F, (key & 0x80) != 0};
+  }
+  fclose(file);
+  return true;
+}
+
+void replay_free(Replay *replay) {
+  free(replay->events);
+  replay->events = NULL;
+}
+
+// Roda count instruções aplicando cada transição exatamente no ciclo em que
+// foi gravada
+uint64_t replay_run(Replay *replay, CPU *chip, const Scheduler *sched,
+                    uint64_t count) {
+  uint64_t end = chip->cycles + count;
+  while (chip->cycles < end) {
+    while (replay->next < replay->header.event_count &&
+           replay->events[replay->next].cycle <= chip->cycles) {
+      const ReplayEvent *event = &replay->events[replay->next++];
+      chip->keys[event->key] = event->down;
+    }
+    uint64_t until = end;
+    if (replay->next < replay->header.event_count &&
+        replay->events[replay->next].cycle < until) {
+      until = replay->events[replay->next].cycle;
+    }
+    run_cycles(chip, sched, until - chip->cycles);
+  }
+  return count;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "cpu.h"
+#include "sched.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define REPLAY_MAGIC 0x50523843u // "C8RP"
+#define REPLAY_VERSION 1
+
+// Gravação de entrada: cabeçalho fixo seguido de um evento por transição de
+// tecla, cada um com o delta de ciclos desde o anterior (varint) e um byte
+// com a tecla (bits 0-3) e o estado (bit 7). Com a mesma ROM, semente e
+// instruções por frame a execução é reproduzida bit a bit.
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t quirks;           // Perfil de compatibilidade (QUIRKS_*)
+  uint32_t seed;             // rng_state no início
+  uint32_t cycles_per_frame; // Afeta quando os timers decrementam
+  uint64_t rom_hash;         // FNV-1a da ROM, para detectar ROM trocada
+  uint64_t end_cycle;        // Duração da sessão gravada
+  uint32_t event_count;
+  uint32_t padding;
+} ReplayHeader;
+
+typedef struct {
+  uint64_t cycle;
+  uint8_t key;
+  uint8_t down;
+} ReplayEvent;
+
+typedef struct {
+  FILE *file;
+  ReplayHeader header;
+  uint64_t last_cycle;
+} Recorder;
+
+typedef struct {
+  ReplayHeader header;
+  ReplayEvent *events;
+  size_t next;
+} Replay;
+
+bool recorder_open(Recorder *recorder, const char *path, const CPU *chip,
+                   const Scheduler *sched, uint64_t rom_hash);
+void recorder_key(Recorder *recorder, uint64_t cycle, uint8_t key, bool down);
+void recorder_close(Recorder *recorder, uint64_t end_cycle);
+
+bool replay_load(Replay *replay, const char *path);
+void replay_free(Replay *replay);
+uint64_t replay_run(Replay *replay, CPU *chip, const Scheduler *sched,
+                    uint64_t count);
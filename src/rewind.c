@@ -0,0 +1,195 @@
+#include "rewind.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DELTA_MAX_BYTES (2 * sizeof(SaveState) + 16)
+#define MIN_ZERO_RUN 2 // Zeros isolados ficam no literal
+
+static size_t put_varint(uint8_t *out, size_t value) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out[n++] = (uint8_t)value;
+  return n;
+}
+
+static size_t get_varint(const uint8_t *in, size_t *value) {
+  size_t n = 0;
+  int shift = 0;
+  *value = 0;
+  do {
+    *value |= (size_t)(in[n] & 0x7F) << shift;
+    shift += 7;
+  } while (in[n++] & 0x80);
+  return n;
+}
+
+// Codifica a XOR b como pares (zeros, literais) seguidos dos bytes literais
+static size_t encode_delta(const uint8_t *a, const uint8_t *b, size_t size,
+                           uint8_t *out) {
+  size_t pos = 0;
+  size_t written = 0;
+  while (pos < size) {
+    size_t zeros = 0;
+    while (pos + zeros < size && a[pos + zeros] == b[pos + zeros]) {
+      zeros++;
+    }
+    pos += zeros;
+    if (pos == size) {
+      break; // Zeros no fim ficam implícitos
+    }
+
+    size_t literal = 0;
+    while (pos + literal < size) {
+      size_t run = 0;
+      while (run < MIN_ZERO_RUN && pos + literal + run < size &&
+             a[pos + literal + run] == b[pos + literal + run]) {
+        run++;
+      }
+      if (run == MIN_ZERO_RUN) {
+        break;
+      }
+      literal += run ? run : 1;
+    }
+
+    written += put_varint(out + written, zeros);
+    written += put_varint(out + written, literal);
+    for (size_t n = 0; n < literal; n++) {
+      out[written++] = a[pos + n] ^ b[pos + n];
+    }
+    pos += literal;
+  }
+  return written;
+}
+
+static void apply_delta(uint8_t *target, size_t size, const uint8_t *delta,
+                        size_t length) {
+  size_t pos = 0;
+  size_t read = 0;
+  while (read < length) {
+    size_t zeros, literal;
+    read += get_varint(delta + read, &zeros);
+    read += get_varint(delta + read, &literal);
+    pos += zeros;
+    for (size_t n = 0; n < literal && pos < size; n++) {
+      target[pos++] ^= delta[read++];
+    }
+  }
+}
+
+bool rewind_init(Rewind *rewind, size_t capacity) {
+  memset(rewind, 0, sizeof(*rewind));
+  rewind->capacity = capacity;
+  // Um registro a cada 16 bytes é mais do que frames sem mudança produzem
+  rewind->max_records = capacity / 16 + 1;
+  rewind->buffer = (uint8_t *)malloc(capacity);
+  rewind->records =
+      (RewindRecord *)malloc(rewind->max_records * sizeof(RewindRecord));
+  rewind->scratch = (uint8_t *)malloc(DELTA_MAX_BYTES);
+  if (!rewind->buffer || !rewind->records || !rewind->scratch) {
+    fprintf(stderr, "Erro: Falha ao alocar o buffer de rewind.\n");
+    rewind_free(rewind);
+    return false;
+  }
+  return true;
+}
+
+void rewind_free(Rewind *rewind) {
+  free(rewind->buffer);
+  free(rewind->records);
+  free(rewind->scratch);
+  rewind->buffer = NULL;
+  rewind->records = NULL;
+  rewind->scratch = NULL;
+}
+
+void rewind_reset(Rewind *rewind) {
+  rewind->first = 0;
+  rewind->count = 0;
+  rewind->has_current = false;
+}
+
+static RewindRecord *record_at(Rewind *rewind, size_t n) {
+  return &rewind->records[(rewind->first + n) % rewind->max_records];
+}
+
+static void drop_oldest(Rewind *rewind) {
+  rewind->first = (rewind->first + 1) % rewind->max_records;
+  rewind->count--;
+}
+
+// Reserva length bytes contíguos, descartando os registros mais antigos
+static bool reserve(Rewind *rewind, size_t length, size_t *offset) {
+  if (length > rewind->capacity) {
+    return false;
+  }
+  if (rewind->count == rewind->max_records) {
+    drop_oldest(rewind);
+  }
+  for (;;) {
+    if (rewind->count == 0) {
+      *offset = 0;
+      return true;
+    }
+    RewindRecord *oldest = record_at(rewind, 0);
+    RewindRecord *newest = record_at(rewind, rewind->count - 1);
+    size_t end = newest->offset + newest->length;
+    if (newest->offset >= oldest->offset) {
+      // Ocupado: [oldest, end). Livre: [end, capacity) e [0, oldest)
+      if (rewind->capacity - end >= length) {
+        *offset = end;
+        return true;
+      }
+      if (oldest->offset >= length) {
+        *offset = 0;
+        return true;
+      }
+    } else if (oldest->offset - end >= length) {
+      // Já deu a volta. Livre: [end, oldest)
+      *offset = end;
+      return true;
+    }
+    drop_oldest(rewind);
+  }
+}
+
+void rewind_push(Rewind *rewind, const CPU *chip) {
+  SaveState *next = &rewind->incoming;
+  save_state(chip, next);
+  if (!rewind->has_current) {
+    rewind->current = *next;
+    rewind->has_current = true;
+    return;
+  }
+
+  // Delta que leva do estado novo de volta para o atual
+  size_t length = encode_delta((const uint8_t *)&rewind->current,
+                               (const uint8_t *)next, sizeof(SaveState),
+                               rewind->scratch);
+  size_t offset;
+  if (!reserve(rewind, length, &offset)) {
+    rewind_reset(rewind);
+  } else {
+    memcpy(rewind->buffer + offset, rewind->scratch, length);
+    *record_at(rewind, rewind->count) = (RewindRecord){offset, length};
+    rewind->count++;
+  }
+  rewind->current = *next;
+  rewind->has_current = true;
+}
+
+bool rewind_step_back(Rewind *rewind, CPU *chip) {
+  if (rewind->count == 0) {
+    return false;
+  }
+  RewindRecord *newest = record_at(rewind, rewind->count - 1);
+  apply_delta((uint8_t *)&rewind->current, sizeof(SaveState),
+              rewind->buffer + newest->offset, newest->length);
+  rewind->count--;
+  return load_state(chip, &rewind->current);
+}
+
+size_t rewind_frames(const Rewind *rewind) { return rewind->count; }
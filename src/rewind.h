@@ -0,0 +1,36 @@
+#pragma once
+#include "state.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define REWIND_DEFAULT_BYTES (4 * 1024 * 1024)
+
+typedef struct {
+  size_t offset;
+  size_t length;
+} RewindRecord;
+
+// Histórico para voltar no tempo. Guarda o estado mais recente inteiro e,
+// para cada frame anterior, o XOR entre ele e o seguinte, comprimido com
+// RLE de zeros. Quando o buffer enche, os registros mais antigos saem.
+typedef struct {
+  uint8_t *buffer;
+  size_t capacity;
+  RewindRecord *records; // Fila circular de registros
+  size_t max_records;
+  size_t first;
+  size_t count;
+
+  SaveState current;
+  SaveState incoming;
+  bool has_current;
+  uint8_t *scratch; // Pior caso de um delta comprimido
+} Rewind;
+
+bool rewind_init(Rewind *rewind, size_t capacity);
+void rewind_free(Rewind *rewind);
+void rewind_reset(Rewind *rewind);
+void rewind_push(Rewind *rewind, const CPU *chip);
+bool rewind_step_back(Rewind *rewind, CPU *chip);
+size_t rewind_frames(const Rewind *rewind);
@@ -0,0 +1,94 @@
+#include "sched.h"
+#include "emu.h"
+#include "idle.h"
+#include "jit.h"
+#include "trace.h"
+
+void initScheduler(Scheduler *sched) {
+  sched->cycles_per_frame = DEFAULT_CYCLES_PER_FRAME;
+  sched->turbo = false;
+  sched->idle_skip = true;
+}
+
+void tick_timers(CPU *chip) {
+  if (chip->delay_timer > 0)
+    chip->delay_timer--;
+  if (chip->sound_timer > 0)
+    chip->sound_timer--;
+}
+
+// Avança o tempo do convidado n instruções sem executá-las, aplicando de
+// uma vez os ticks dos timers que caem no intervalo
+static void skip_cycles(CPU *chip, const Scheduler *sched, uint64_t n) {
+  uint64_t ticks = (chip->cycles % sched->cycles_per_frame + n) /
+                   sched->cycles_per_frame;
+  chip->delay_timer = ticks < chip->delay_timer ? chip->delay_timer - ticks : 0;
+  chip->sound_timer = ticks < chip->sound_timer ? chip->sound_timer - ticks : 0;
+  chip->cycles += n;
+}
+
+// Quantas instruções de count podem ser puladas a partir do PC atual. O
+// resultado é idêntico ao de executá-las; o resto roda normalmente.
+static uint64_t idle_cycles(CPU *chip, uint64_t count, uint64_t to_tick) {
+  IdleLoop loop;
+  if (!idle_detect(chip, &loop)) {
+    return 0;
+  }
+  if (loop.kind == IDLE_SPIN) {
+    // Só os timers mudam: pula tudo, atravessando quantos ticks houver
+    return count - count % loop.period;
+  }
+  // IDLE_TIMER: o delay timer só é constante até o próximo tick
+  uint64_t budget = count < to_tick ? count : to_tick;
+  if (budget < loop.lead + loop.period) {
+    return 0;
+  }
+  uint64_t laps = (budget - loop.lead) / loop.period;
+  chip->pc = loop.head;
+  chip->v[loop.x] = chip->delay_timer;
+  return loop.lead + laps * loop.period;
+}
+
+uint64_t run_cycles(CPU *chip, const Scheduler *sched, uint64_t count) {
+  uint64_t done = 0;
+  bool probe = true;
+  while (done < count) {
+    // Executa até a próxima fronteira de frame, onde os timers decrementam
+    uint64_t to_tick =
+        sched->cycles_per_frame - chip->cycles % sched->cycles_per_frame;
+    // Com o profiler ou o trace cada instrução precisa ser executada
+    bool observed = chip->trace != NULL || chip->profile != NULL;
+    if (sched->idle_skip && probe && !observed) {
+      uint64_t idle = idle_cycles(chip, count - done, to_tick);
+      if (idle > 0) {
+        skip_cycles(chip, sched, idle);
+        done += idle;
+        continue;
+      }
+    }
+    uint64_t chunk = count - done < to_tick ? count - done : to_tick;
+    uint16_t start = chip->pc;
+    if (chip->jit && !observed) {
+      jit_run(chip->jit, chip, chunk);
+    } else {
+      if (chip->trace != NULL) {
+        trace_chunk(chip->trace, chip);
+      }
+      chip->interp->run(chip, chunk);
+    }
+    // Os laços de espera têm no máximo 3 instruções: só vale procurar de
+    // novo se o frame terminou perto de onde começou
+    probe = (uint16_t)(chip->pc - start + 4) <= 8;
+    chip->cycles += chunk;
+    done += chunk;
+    if (chunk == to_tick) {
+      tick_timers(chip);
+    }
+  }
+  return done;
+}
+
+void run_frame(CPU *chip, const Scheduler *sched) {
+  run_cycles(chip, sched,
+             sched->cycles_per_frame - chip->cycles % sched->cycles_per_frame);
+}
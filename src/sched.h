@@ -0,0 +1,21 @@
+#pragma once
+#include "cpu.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TIMER_HZ 60
+#define DEFAULT_CYCLES_PER_FRAME 10 // 600 instruções por segundo
+#define FRAME_MS (1000 / TIMER_HZ)
+
+// Escalonador: a CPU roda cycles_per_frame instruções por frame e os timers
+// decrementam uma vez por frame, ou seja, a 60 Hz do tempo do convidado.
+typedef struct {
+  uint32_t cycles_per_frame;
+  bool turbo;     // Sem limitar a velocidade ao relógio real
+  bool idle_skip; // Avança o tempo em laços de espera sem executá-los
+} Scheduler;
+
+void initScheduler(Scheduler *sched);
+void tick_timers(CPU *chip);
+uint64_t run_cycles(CPU *chip, const Scheduler *sched, uint64_t count);
+void run_frame(CPU *chip, const Scheduler *sched);
@@ -0,0 +1,89 @@
+#include "screen.h"
+#include <string.h>
+
+#define ROW_BYTES sizeof(uint64_t[ROW_WORDS])
+
+void screen_clear(Screen *screen, uint8_t planes) {
+  for (int p = 0; p < SCREEN_PLANES; p++) {
+    if (planes & (1 << p)) {
+      memset(screen->rows[p], 0, sizeof(screen->rows[p]));
+    }
+  }
+}
+
+// 00FE/00FF: trocar de resolução apaga a tela, como no XO-CHIP
+void screen_set_hires(Screen *screen, bool hires) {
+  screen->hires = hires;
+  memset(screen->rows, 0, sizeof(screen->rows));
+}
+
+// 00CN: desce n linhas; as do topo ficam apagadas
+void screen_scroll_down(Screen *screen, uint8_t planes, int n) {
+  int height = screen_height(screen);
+  if (n > height) {
+    n = height;
+  }
+  for (int p = 0; p < SCREEN_PLANES; p++) {
+    if (planes & (1 << p)) {
+      memmove(screen->rows[p][n], screen->rows[p][0],
+              (size_t)(height - n) * ROW_BYTES);
+      memset(screen->rows[p][0], 0, (size_t)n * ROW_BYTES);
+    }
+  }
+}
+
+// 00DN (XO-CHIP): sobe n linhas; as de baixo ficam apagadas
+void screen_scroll_up(Screen *screen, uint8_t planes, int n) {
+  int height = screen_height(screen);
+  if (n > height) {
+    n = height;
+  }
+  for (int p = 0; p < SCREEN_PLANES; p++) {
+    if (planes & (1 << p)) {
+      memmove(screen->rows[p][0], screen->rows[p][n],
+              (size_t)(height - n) * ROW_BYTES);
+      memset(screen->rows[p][height - n], 0, (size_t)n * ROW_BYTES);
+    }
+  }
+}
+
+// 00FB: 4 pixels para a direita. Em alta resolução os bits que saem da
+// primeira palavra entram na segunda.
+void screen_scroll_right(Screen *screen, uint8_t planes) {
+  for (int p = 0; p < SCREEN_PLANES; p++) {
+    if (!(planes & (1 << p))) {
+      continue;
+    }
+    if (screen->hires) {
+      for (int y = 0; y < HIRES_HEIGHT; y++) {
+        uint64_t *row = screen->rows[p][y];
+        row[1] = (row[1] >> 4) | (row[0] << 60);
+        row[0] >>= 4;
+      }
+    } else {
+      for (int y = 0; y < SCREEN_HEIGHT; y++) {
+        screen->rows[p][y][0] >>= 4;
+      }
+    }
+  }
+}
+
+// 00FC: 4 pixels para a esquerda
+void screen_scroll_left(Screen *screen, uint8_t planes) {
+  for (int p = 0; p < SCREEN_PLANES; p++) {
+    if (!(planes & (1 << p))) {
+      continue;
+    }
+    if (screen->hires) {
+      for (int y = 0; y < HIRES_HEIGHT; y++) {
+        uint64_t *row = screen->rows[p][y];
+        row[0] = (row[0] << 4) | (row[1] >> 60);
+        row[1] <<= 4;
+      }
+    } else {
+      for (int y = 0; y < SCREEN_HEIGHT; y++) {
+        screen->rows[p][y][0] <<= 4;
+      }
+    }
+  }
+}
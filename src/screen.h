@@ -0,0 +1,43 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SCREEN_WIDTH 64  // Baixa resolução (CHIP-8)
+#define SCREEN_HEIGHT 32
+#define HIRES_WIDTH 128 // Alta resolução (SUPER-CHIP, XO-CHIP)
+#define HIRES_HEIGHT 64
+#define SCREEN_PLANES 2 // Planos de bits do XO-CHIP
+#define ROW_WORDS (HIRES_WIDTH / 64)
+
+// Tela de 1 bit por pixel e por plano. Cada linha tem 128 bits em duas
+// palavras (bit 63 da primeira = x 0, bit 63 da segunda = x 64). Em baixa
+// resolução só a primeira palavra das 32 primeiras linhas é usada, com o
+// mesmo layout do CHIP-8 original. Rolagem e limpeza trabalham com linhas
+// e palavras inteiras, nunca pixel a pixel.
+typedef struct {
+  uint64_t rows[SCREEN_PLANES][HIRES_HEIGHT][ROW_WORDS];
+  bool hires;
+} Screen;
+
+static inline int screen_width(const Screen *screen) {
+  return screen->hires ? HIRES_WIDTH : SCREEN_WIDTH;
+}
+
+static inline int screen_height(const Screen *screen) {
+  return screen->hires ? HIRES_HEIGHT : SCREEN_HEIGHT;
+}
+
+// Cor do pixel: bit 0 = plano 0, bit 1 = plano 1
+static inline uint8_t screen_pixel_at(const Screen *screen, int x, int y) {
+  int shift = 63 - (x & 63);
+  return ((screen->rows[0][y][x >> 6] >> shift) & 1) |
+         (((screen->rows[1][y][x >> 6] >> shift) & 1) << 1);
+}
+
+// Todas as operações abaixo afetam só os planos marcados em planes
+void screen_clear(Screen *screen, uint8_t planes);
+void screen_set_hires(Screen *screen, bool hires);
+void screen_scroll_down(Screen *screen, uint8_t planes, int n);
+void screen_scroll_up(Screen *screen, uint8_t planes, int n);
+void screen_scroll_right(Screen *screen, uint8_t planes);
+void screen_scroll_left(Screen *screen, uint8_t planes);
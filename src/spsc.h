@@ -0,0 +1,57 @@
+#pragma once
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Fila lock-free de um produtor e um consumidor. A capacidade deve ser
+// potência de 2; o armazenamento é fornecido por quem cria a fila.
+typedef struct {
+  _Atomic size_t head; // Escrito só pelo produtor
+  _Atomic size_t tail; // Escrito só pelo consumidor
+  size_t mask;
+  size_t elem_size;
+  uint8_t *data;
+} SpscRing;
+
+static inline void spsc_init(SpscRing *ring, void *storage, size_t capacity,
+                             size_t elem_size) {
+  atomic_init(&ring->head, 0);
+  atomic_init(&ring->tail, 0);
+  ring->mask = capacity - 1;
+  ring->elem_size = elem_size;
+  ring->data = (uint8_t *)storage;
+}
+
+static inline bool spsc_push(SpscRing *ring, const void *item) {
+  size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+  if (head - tail > ring->mask) {
+    return false; // Cheia
+  }
+  memcpy(ring->data + (head & ring->mask) * ring->elem_size, item,
+         ring->elem_size);
+  atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+  return true;
+}
+
+static inline bool spsc_peek(SpscRing *ring, void *item) {
+  size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+  if (head == tail) {
+    return false; // Vazia
+  }
+  memcpy(item, ring->data + (tail & ring->mask) * ring->elem_size,
+         ring->elem_size);
+  return true;
+}
+
+static inline bool spsc_pop(SpscRing *ring, void *item) {
+  if (!spsc_peek(ring, item)) {
+    return false;
+  }
+  size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+  return true;
+}
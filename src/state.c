@@ -0,0 +1,68 @@
+#include "state.h"
+#include <stdio.h>
+#include <string.h>
+
+void save_state(const CPU *chip, SaveState *state) {
+  // memset garante bytes de preenchimento estáveis para os deltas do rewind
+  memset(state, 0, sizeof(*state));
+  state->magic = STATE_MAGIC;
+  state->version = STATE_VERSION;
+  state->cycles = chip->cycles;
+  state->rng_state = chip->rng_state;
+  state->i = chip->i;
+  state->pc = chip->pc;
+  memcpy(state->stack, chip->stack, sizeof(state->stack));
+  memcpy(state->v, chip->v, sizeof(state->v));
+  state->sp = chip->sp;
+  state->delay_timer = chip->delay_timer;
+  state->sound_timer = chip->sound_timer;
+  state->fault = chip->fault;
+  state->fault_pc = chip->fault_pc;
+  memcpy(state->keys, chip->keys, sizeof(state->keys));
+  memcpy(state->rpl, chip->rpl, sizeof(state->rpl));
+  memcpy(state->audio_pattern, chip->audio_pattern,
+         sizeof(state->audio_pattern));
+  state->planes = chip->planes;
+  state->pitch = chip->pitch;
+  state->has_pattern = chip->has_pattern;
+  state->hires = chip->screen.hires;
+  memcpy(state->screen, chip->screen.rows, sizeof(state->screen));
+  memcpy(state->memory, chip->dram.memory, sizeof(state->memory));
+}
+
+bool load_state(CPU *chip, const SaveState *state) {
+  if (state->magic != STATE_MAGIC || state->version != STATE_VERSION) {
+    fprintf(stderr, "Erro: Estado salvo inválido ou de outra versão.\n");
+    return false;
+  }
+  chip->cycles = state->cycles;
+  chip->rng_state = state->rng_state;
+  chip->i = state->i;
+  chip->pc = state->pc;
+  memcpy(chip->stack, state->stack, sizeof(chip->stack));
+  memcpy(chip->v, state->v, sizeof(chip->v));
+  chip->sp = state->sp;
+  chip->delay_timer = state->delay_timer;
+  chip->sound_timer = state->sound_timer;
+  chip->fault = state->fault;
+  chip->fault_pc = state->fault_pc;
+  memcpy(chip->keys, state->keys, sizeof(chip->keys));
+  memcpy(chip->rpl, state->rpl, sizeof(chip->rpl));
+  memcpy(chip->audio_pattern, state->audio_pattern,
+         sizeof(chip->audio_pattern));
+  chip->planes = state->planes;
+  chip->pitch = state->pitch;
+  chip->has_pattern = state->has_pattern;
+  chip->screen.hires = state->hires;
+  memcpy(chip->screen.rows, state->screen, sizeof(chip->screen.rows));
+  // Só as instruções sobre bytes que mudaram são decodificadas de novo:
+  // voltar a um estado próximo (rewind, fuzzer) mantém o cache quente
+  for (size_t a = 0; a < MEMORY_SIZE; a += 8) {
+    if (memcmp(&chip->dram.memory[a], &state->memory[a], 8) != 0) {
+      memcpy(&chip->dram.memory[a], &state->memory[a], 8);
+      invalidate_decode(chip, (uint16_t)a, 8);
+    }
+  }
+  chip->draw_flag = true;
+  return true;
+}
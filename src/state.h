@@ -0,0 +1,40 @@
+#pragma once
+#include "cpu.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define STATE_MAGIC 0x53384843u // "CH8S"
+#define STATE_VERSION 3
+
+// Snapshot com layout fixo: copiar para dentro e para fora é só memcpy.
+// Caches (decodificação, JIT) não fazem parte do estado; na restauração só
+// as entradas sobre a memória que mudou são descartadas.
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t reserved;
+  uint64_t cycles;
+  uint32_t rng_state;
+  uint16_t i;
+  uint16_t pc;
+  uint16_t stack[STACK_SIZE];
+  uint8_t v[NUM_REGISTERS];
+  uint8_t sp;
+  uint8_t delay_timer;
+  uint8_t sound_timer;
+  uint8_t fault;
+  uint8_t keys[KEYS];
+  uint8_t rpl[NUM_REGISTERS];
+  uint8_t audio_pattern[AUDIO_PATTERN_SIZE];
+  uint8_t planes;
+  uint8_t pitch;
+  uint8_t has_pattern;
+  uint8_t hires;
+  uint16_t fault_pc;
+  uint16_t padding;
+  uint64_t screen[SCREEN_PLANES][HIRES_HEIGHT][ROW_WORDS];
+  uint8_t memory[MEMORY_SIZE];
+} SaveState;
+
+void save_state(const CPU *chip, SaveState *state);
+bool load_state(CPU *chip, const SaveState *state);
@@ -0,0 +1,152 @@
+#include "trace.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include "spsc.h"
+#include <pthread.h>
+#include <time.h>
+
+struct Trace {
+  SpscRing ring;
+  TraceRecord *records;
+  FILE *file;
+  uint64_t cycle; // Ciclo do próximo registro (só a CPU mexe)
+  atomic_bool running;
+  pthread_t thread;
+  TraceRecord batch[TRACE_BATCH_RECORDS]; // Só a thread de gravação mexe
+};
+
+// Esvazia o anel em lotes; retorna quantos registros gravou
+static size_t drain(struct Trace *trace) {
+  size_t count = 0;
+  while (count < TRACE_BATCH_RECORDS &&
+         spsc_pop(&trace->ring, &trace->batch[count])) {
+    count++;
+  }
+  if (count > 0) {
+    fwrite(trace->batch, sizeof(TraceRecord), count, trace->file);
+  }
+  return count;
+}
+
+static void *writer_main(void *arg) {
+  struct Trace *trace = (struct Trace *)arg;
+  const struct timespec pause = {0, 1000000}; // 1 ms
+  while (atomic_load_explicit(&trace->running, memory_order_acquire)) {
+    if (drain(trace) == 0) {
+      nanosleep(&pause, NULL);
+    }
+  }
+  // A CPU já parou de produzir: grava o resto
+  while (drain(trace) > 0) {
+  }
+  return NULL;
+}
+
+struct Trace *trace_open(const char *path, const CPU *chip) {
+  struct Trace *trace = (struct Trace *)calloc(1, sizeof(struct Trace));
+  if (trace == NULL) {
+    fprintf(stderr, "Erro: Falha ao alocar o trace.\n");
+    return NULL;
+  }
+  trace->records =
+      (TraceRecord *)malloc(TRACE_RING_RECORDS * sizeof(TraceRecord));
+  trace->file = fopen(path, "wb");
+  if (trace->records == NULL || trace->file == NULL) {
+    perror("Erro ao criar o trace");
+    if (trace->file) {
+      fclose(trace->file);
+    }
+    free(trace->records);
+    free(trace);
+    return NULL;
+  }
+
+  TraceHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = TRACE_MAGIC;
+  header.version = TRACE_VERSION;
+  header.quirks = chip->quirks;
+  header.start_cycle = chip->cycles;
+  memcpy(header.v, chip->v, sizeof(header.v));
+  header.i = chip->i;
+  header.pc = chip->pc;
+  fwrite(&header, sizeof(header), 1, trace->file);
+
+  spsc_init(&trace->ring, trace->records, TRACE_RING_RECORDS,
+            sizeof(TraceRecord));
+  trace->cycle = chip->cycles;
+  atomic_init(&trace->running, true);
+  if (pthread_create(&trace->thread, NULL, writer_main, trace) != 0) {
+    fprintf(stderr, "Erro: Falha ao criar a thread do trace.\n");
+    fclose(trace->file);
+    free(trace->records);
+    free(trace);
+    return NULL;
+  }
+  return trace;
+}
+
+void trace_close(struct Trace *trace) {
+  if (trace == NULL) {
+    return;
+  }
+  atomic_store_explicit(&trace->running, false, memory_order_release);
+  pthread_join(trace->thread, NULL);
+  if (fclose(trace->file) != 0) {
+    perror("Erro ao gravar o trace");
+  }
+  free(trace->records);
+  free(trace);
+}
+
+void trace_chunk(struct Trace *trace, const CPU *chip) {
+  trace->cycle = chip->cycles;
+}
+
+void trace_step(struct Trace *trace, const CPU *chip, uint16_t pc,
+                uint16_t opcode, const uint8_t *before) {
+  TraceRecord record = {trace->cycle++, pc, opcode, chip->i, TRACE_NO_REG, 0};
+  for (int r = 0; r < NUM_REGISTERS; r++) {
+    if (chip->v[r] != before[r]) {
+      record.reg = (uint8_t)r;
+      record.value = chip->v[r];
+      if (r != 0xF) {
+        break;
+      }
+    }
+  }
+  // Anel cheio: espera a thread de gravação abrir espaço
+  const struct timespec pause = {0, 100000}; // 0,1 ms
+  while (!spsc_push(&trace->ring, &record)) {
+    nanosleep(&pause, NULL);
+  }
+}
+
+#else
+
+struct Trace *trace_open(const char *path, const CPU *chip) {
+  (void)path;
+  (void)chip;
+  fprintf(stderr, "Trace indisponível nesta plataforma.\n");
+  return NULL;
+}
+
+void trace_close(struct Trace *trace) { (void)trace; }
+
+void trace_chunk(struct Trace *trace, const CPU *chip) {
+  (void)trace;
+  (void)chip;
+}
+
+void trace_step(struct Trace *trace, const CPU *chip, uint16_t pc,
+                uint16_t opcode, const uint8_t *before) {
+  (void)trace;
+  (void)chip;
+  (void)pc;
+  (void)opcode;
+  (void)before;
+}
+
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+#include "cpu.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define TRACE_MAGIC 0x54384843u // "CH8T"
+#define TRACE_VERSION 1
+#define TRACE_RING_RECORDS 65536 // 1 MB entre a CPU e a thread de gravação
+#define TRACE_BATCH_RECORDS 4096 // Registros por fwrite
+#define TRACE_NO_REG 0xFF
+
+// Arquivo de trace: cabeçalho com o estado inicial seguido de um registro
+// de tamanho fixo por instrução executada, até o fim do arquivo. Lido por
+// tools/tracedump.c (chip8-trace).
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t quirks; // Para decodificar os opcodes como a CPU decodificou
+  uint64_t start_cycle;
+  uint8_t v[NUM_REGISTERS];
+  uint16_t i;
+  uint16_t pc;
+  uint32_t padding;
+} TraceHeader;
+
+typedef struct {
+  uint64_t cycle;
+  uint16_t pc;
+  uint16_t opcode;
+  uint16_t i;    // I depois da instrução
+  uint8_t reg;   // Registrador alterado (TRACE_NO_REG = nenhum); com mais de
+                 // um, o de menor índice fora o VF
+  uint8_t value; // Valor novo dele
+} TraceRecord;
+
+// Trace de uma instância (definida em trace.c). A CPU produz os registros
+// num anel e uma thread em segundo plano os grava no arquivo, então a
+// emulação nunca espera por stdio; com o anel cheio (disco mais lento que
+// a CPU) ela espera a thread.
+struct Trace;
+
+// Abre o arquivo, grava o cabeçalho com o estado atual de chip e inicia a
+// thread de gravação. NULL em caso de erro ou sem suporte a threads.
+struct Trace *trace_open(const char *path, const CPU *chip);
+// Grava o que falta no anel e fecha o arquivo
+void trace_close(struct Trace *trace);
+// Início de um trecho executado de uma vez por run_cycles. chip->cycles só
+// avança no fim do trecho, então os registros seguintes são numerados a
+// partir dele; depois de load ou rewind os ciclos continuam batendo.
+void trace_chunk(struct Trace *trace, const CPU *chip);
+// Registra uma instrução executada; before são os registradores antes dela
+void trace_step(struct Trace *trace, const CPU *chip, uint16_t pc,
+                uint16_t opcode, const uint8_t *before);
@@ -0,0 +1,77 @@
+#pragma once
+#include "cpu.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define TRIPLE_FRESH 0x4 // Buffer do meio tem um frame ainda não lido
+
+// Frame completo publicado pela emulação
+typedef struct {
+  Screen screen;
+  uint64_t number; // Frame do convidado em que foi publicado
+  uint64_t input_time; // Chegada da tecla mais antiga que este frame é o
+                       // primeiro a mostrar (0 = nenhuma), para medir a
+                       // latência até a tela
+} Frame;
+
+// Buffer triplo lock-free: o produtor escreve em back, o consumidor lê de
+// front e os dois trocam de buffer com o do meio por um exchange atômico.
+// Nenhum lado espera pelo outro; o consumidor sempre recebe o frame mais
+// recente e frames intermediários são descartados.
+typedef struct {
+  Frame buffers[3];
+  _Atomic uint8_t middle; // Índice | TRIPLE_FRESH
+  uint8_t back;           // Só o produtor usa
+  uint8_t front;          // Só o consumidor usa
+} TripleBuffer;
+
+static inline void triple_init(TripleBuffer *triple) {
+  memset(triple->buffers, 0, sizeof(triple->buffers));
+  triple->back = 0;
+  atomic_init(&triple->middle, 1);
+  triple->front = 2;
+}
+
+static inline Frame *triple_back(TripleBuffer *triple) {
+  return &triple->buffers[triple->back];
+}
+
+// Se o frame do meio ainda não foi lido ele é descartado, e o novo herda a
+// tecla mais antiga dele: a tela só a mostra a partir deste. O consumidor só
+// tira o FRESH, então se o CAS falhar o meio já foi lido e basta o carimbo
+// do próprio frame.
+static inline void triple_publish(TripleBuffer *triple) {
+  Frame *frame = &triple->buffers[triple->back];
+  uint64_t own = frame->input_time;
+  uint8_t old = atomic_load_explicit(&triple->middle, memory_order_relaxed);
+  do {
+    frame->input_time = own;
+    if (old & TRIPLE_FRESH) {
+      uint64_t dropped = triple->buffers[old & 0x3].input_time;
+      if (dropped != 0 && (own == 0 || dropped < own)) {
+        frame->input_time = dropped;
+      }
+    }
+  } while (!atomic_compare_exchange_weak_explicit(
+      &triple->middle, &old, triple->back | TRIPLE_FRESH,
+      memory_order_acq_rel, memory_order_relaxed));
+  triple->back = old & 0x3;
+}
+
+// Retorna true se havia um frame novo; front() passa a apontar para ele
+static inline bool triple_acquire(TripleBuffer *triple) {
+  if (!(atomic_load_explicit(&triple->middle, memory_order_relaxed) &
+        TRIPLE_FRESH)) {
+    return false;
+  }
+  uint8_t old = atomic_exchange_explicit(&triple->middle, triple->front,
+                                         memory_order_acq_rel);
+  triple->front = old & 0x3;
+  return true;
+}
+
+static inline const Frame *triple_front(const TripleBuffer *triple) {
+  return &triple->buffers[triple->front];
+}
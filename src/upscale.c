@@ -0,0 +1,360 @@
+#include "upscale.h"
+#include "framebuffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define UPSCALE_X86 1
+#include <immintrin.h>
+#endif
+
+#define SCRATCH_SCALE 3 // Maior fator dos filtros de pixel art
+
+static const char *const names[UPSCALE_COUNT] = {
+    [UPSCALE_NEAREST] = "nearest",
+    [UPSCALE_SCALE2X] = "scale2x",
+    [UPSCALE_SCALE3X] = "scale3x",
+    [UPSCALE_CRT] = "crt",
+};
+
+const char *upscale_filter_name(int filter) {
+  return filter >= 0 && filter < UPSCALE_COUNT ? names[filter] : "?";
+}
+
+int upscale_filter_from_name(const char *name) {
+  for (int f = 0; f < UPSCALE_COUNT; f++) {
+    if (strcmp(name, names[f]) == 0) {
+      return f;
+    }
+  }
+  return -1;
+}
+
+// Metade do brilho, mantendo o alfa
+static inline uint32_t dim_pixel(uint32_t color) {
+  return ((color >> 1) & 0x007F7F7Fu) | 0xFF000000u;
+}
+
+static void expand_row_scalar(const uint32_t *src, int count, int factor,
+                              uint32_t *dst) {
+  for (int x = 0; x < count; x++) {
+    for (int r = 0; r < factor; r++) {
+      *dst++ = src[x];
+    }
+  }
+}
+
+static void dim_row_scalar(const uint32_t *src, int count, uint32_t *dst) {
+  for (int x = 0; x < count; x++) {
+    dst[x] = dim_pixel(src[x]);
+  }
+}
+
+static void copy_row_scalar(const uint32_t *src, int count, uint32_t *dst) {
+  memcpy(dst, src, (size_t)count * sizeof(uint32_t));
+}
+
+#ifdef UPSCALE_X86
+// Cada pixel é repetido com gravações de 4 pixels; a última do bloco é
+// alinhada ao fim dele e pode sobrepor a anterior, então não há laço de
+// sobra para fatores que não são múltiplos de 4
+__attribute__((target("sse2"))) static void
+expand_row_sse2(const uint32_t *src, int count, int factor, uint32_t *dst) {
+  if (factor < 4) {
+    expand_row_scalar(src, count, factor, dst);
+    return;
+  }
+  for (int x = 0; x < count; x++, dst += factor) {
+    __m128i color = _mm_set1_epi32((int)src[x]);
+    for (int r = 0; r + 4 <= factor; r += 4) {
+      _mm_storeu_si128((__m128i *)(dst + r), color);
+    }
+    _mm_storeu_si128((__m128i *)(dst + factor - 4), color);
+  }
+}
+
+__attribute__((target("sse2"))) static void
+dim_row_sse2(const uint32_t *src, int count, uint32_t *dst) {
+  const __m128i mask = _mm_set1_epi32(0x007F7F7F);
+  const __m128i alpha = _mm_set1_epi32((int)0xFF000000u);
+  int x = 0;
+  for (; x + 4 <= count; x += 4) {
+    __m128i color = _mm_loadu_si128((const __m128i *)(src + x));
+    color = _mm_and_si128(_mm_srli_epi32(color, 1), mask);
+    _mm_storeu_si128((__m128i *)(dst + x), _mm_or_si128(color, alpha));
+  }
+  dim_row_scalar(src + x, count - x, dst + x);
+}
+
+// Gravações não temporárias: a saída (vários MB em 1080p) não polui o cache
+// nem é lida antes de ser escrita
+__attribute__((target("sse2"))) static void
+copy_row_sse2(const uint32_t *src, int count, uint32_t *dst) {
+  int x = 0;
+  for (; x < count && ((uintptr_t)(dst + x) & 15) != 0; x++) {
+    dst[x] = src[x];
+  }
+  for (; x + 4 <= count; x += 4) {
+    _mm_stream_si128((__m128i *)(dst + x),
+                     _mm_loadu_si128((const __m128i *)(src + x)));
+  }
+  for (; x < count; x++) {
+    dst[x] = src[x];
+  }
+}
+
+__attribute__((target("sse2"))) static void store_fence(void) {
+  _mm_sfence();
+}
+
+__attribute__((target("avx2"))) static void
+expand_row_avx2(const uint32_t *src, int count, int factor, uint32_t *dst) {
+  if (factor < 8) {
+    expand_row_sse2(src, count, factor, dst);
+    return;
+  }
+  for (int x = 0; x < count; x++, dst += factor) {
+    __m256i color = _mm256_set1_epi32((int)src[x]);
+    for (int r = 0; r + 8 <= factor; r += 8) {
+      _mm256_storeu_si256((__m256i *)(dst + r), color);
+    }
+    _mm256_storeu_si256((__m256i *)(dst + factor - 8), color);
+  }
+}
+
+__attribute__((target("avx2"))) static void
+dim_row_avx2(const uint32_t *src, int count, uint32_t *dst) {
+  const __m256i mask = _mm256_set1_epi32(0x007F7F7F);
+  const __m256i alpha = _mm256_set1_epi32((int)0xFF000000u);
+  int x = 0;
+  for (; x + 8 <= count; x += 8) {
+    __m256i color = _mm256_loadu_si256((const __m256i *)(src + x));
+    color = _mm256_and_si256(_mm256_srli_epi32(color, 1), mask);
+    _mm256_storeu_si256((__m256i *)(dst + x), _mm256_or_si256(color, alpha));
+  }
+  dim_row_scalar(src + x, count - x, dst + x);
+}
+
+__attribute__((target("avx2"))) static void
+copy_row_avx2(const uint32_t *src, int count, uint32_t *dst) {
+  int x = 0;
+  for (; x < count && ((uintptr_t)(dst + x) & 31) != 0; x++) {
+    dst[x] = src[x];
+  }
+  for (; x + 8 <= count; x += 8) {
+    _mm256_stream_si256((__m256i *)(dst + x),
+                        _mm256_loadu_si256((const __m256i *)(src + x)));
+  }
+  for (; x < count; x++) {
+    dst[x] = src[x];
+  }
+}
+#endif
+
+bool upscaler_init(Upscaler *upscaler, int filter) {
+  upscaler->filter = filter;
+  upscaler->max_width = HIRES_WIDTH;
+  upscaler->max_height = HIRES_HEIGHT;
+  upscaler->lines = NULL;
+  upscaler->line_capacity = 0;
+  upscaler->source =
+      (uint32_t *)malloc(HIRES_WIDTH * HIRES_HEIGHT * sizeof(uint32_t));
+  upscaler->scratch = (uint32_t *)malloc(
+      HIRES_WIDTH * HIRES_HEIGHT * SCRATCH_SCALE * SCRATCH_SCALE *
+      sizeof(uint32_t));
+  if (upscaler->source == NULL || upscaler->scratch == NULL) {
+    fprintf(stderr, "Erro: Falha ao alocar o buffer do filtro.\n");
+    upscaler_free(upscaler);
+    return false;
+  }
+
+  upscaler->expand_row = expand_row_scalar;
+  upscaler->dim_row = dim_row_scalar;
+  upscaler->copy_row = copy_row_scalar;
+  upscaler->kernel = "scalar";
+#ifdef UPSCALE_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    upscaler->expand_row = expand_row_avx2;
+    upscaler->dim_row = dim_row_avx2;
+    upscaler->copy_row = copy_row_avx2;
+    upscaler->kernel = "avx2";
+  } else if (__builtin_cpu_supports("sse2")) {
+    upscaler->expand_row = expand_row_sse2;
+    upscaler->dim_row = dim_row_sse2;
+    upscaler->copy_row = copy_row_sse2;
+    upscaler->kernel = "sse2";
+  }
+#endif
+  if (!upscaler_resize(upscaler, HIRES_WIDTH, HIRES_HEIGHT)) {
+    upscaler_free(upscaler);
+    return false;
+  }
+  return true;
+}
+
+void upscaler_free(Upscaler *upscaler) {
+  free(upscaler->source);
+  free(upscaler->scratch);
+  free(upscaler->lines);
+  upscaler->source = NULL;
+  upscaler->scratch = NULL;
+  upscaler->lines = NULL;
+}
+
+bool upscaler_resize(Upscaler *upscaler, int width, int height) {
+  // A linha mais larga: a área inteira ou o mínimo do Scale3x
+  int capacity = width > HIRES_WIDTH * SCRATCH_SCALE
+                     ? width
+                     : HIRES_WIDTH * SCRATCH_SCALE;
+  if (capacity > upscaler->line_capacity) {
+    uint32_t *lines = (uint32_t *)realloc(
+        upscaler->lines, 2 * (size_t)capacity * sizeof(uint32_t));
+    if (lines == NULL) {
+      // Continua com a área anterior, que cabe no buffer antigo
+      fprintf(stderr, "Erro: Falha ao alocar o buffer do filtro.\n");
+      return false;
+    }
+    upscaler->lines = lines;
+    upscaler->line_capacity = capacity;
+  }
+  upscaler->max_width = width;
+  upscaler->max_height = height;
+  return true;
+}
+
+int upscaler_factor(const Upscaler *upscaler, const Screen *screen) {
+  int fit_x = upscaler->max_width / screen_width(screen);
+  int fit_y = upscaler->max_height / screen_height(screen);
+  int factor = fit_x < fit_y ? fit_x : fit_y;
+  int base = upscaler->filter == UPSCALE_SCALE2X   ? 2
+             : upscaler->filter == UPSCALE_SCALE3X ? 3
+                                                   : 1;
+  // Janela menor que o mínimo do filtro: gera assim mesmo e a cópia reduz
+  factor -= factor % base;
+  return factor > base ? factor : base;
+}
+
+void upscaler_output_size(const Upscaler *upscaler, const Screen *screen,
+                          int *width, int *height) {
+  int factor = upscaler_factor(upscaler, screen);
+  *width = screen_width(screen) * factor;
+  *height = screen_height(screen) * factor;
+}
+
+// Scale2x (EPX): cada pixel P vira 2x2 conforme os vizinhos
+//     A         E0 E1
+//   C P B  ->   E2 E3
+//     D
+// nas bordas o vizinho que falta é o próprio P
+static void scale2x(const uint32_t *src, int width, int height,
+                    uint32_t *dst) {
+  for (int y = 0; y < height; y++) {
+    const uint32_t *row = src + y * width;
+    const uint32_t *up = y > 0 ? row - width : row;
+    const uint32_t *down = y < height - 1 ? row + width : row;
+    uint32_t *out0 = dst + 2 * y * 2 * width;
+    uint32_t *out1 = out0 + 2 * width;
+    for (int x = 0; x < width; x++) {
+      uint32_t p = row[x];
+      uint32_t a = up[x];
+      uint32_t d = down[x];
+      uint32_t c = x > 0 ? row[x - 1] : p;
+      uint32_t b = x < width - 1 ? row[x + 1] : p;
+      out0[2 * x] = c == a && c != d && a != b ? a : p;
+      out0[2 * x + 1] = a == b && a != c && b != d ? b : p;
+      out1[2 * x] = d == c && d != b && c != a ? c : p;
+      out1[2 * x + 1] = b == d && b != a && d != c ? d : p;
+    }
+  }
+}
+
+// Scale3x (AdvMAME3x): vizinhança 3x3 A..I em volta de E
+static void scale3x(const uint32_t *src, int width, int height,
+                    uint32_t *dst) {
+  for (int y = 0; y < height; y++) {
+    const uint32_t *row = src + y * width;
+    const uint32_t *up = y > 0 ? row - width : row;
+    const uint32_t *down = y < height - 1 ? row + width : row;
+    uint32_t *out[3];
+    for (int r = 0; r < 3; r++) {
+      out[r] = dst + (3 * y + r) * 3 * width;
+    }
+    for (int x = 0; x < width; x++) {
+      int l = x > 0 ? x - 1 : x;
+      int r = x < width - 1 ? x + 1 : x;
+      uint32_t a = up[l], b = up[x], c = up[r];
+      uint32_t d = row[l], e = row[x], f = row[r];
+      uint32_t g = down[l], h = down[x], i = down[r];
+      bool db = d == b && d != h && b != f;
+      bool bf = b == f && b != d && f != h;
+      bool dh = d == h && d != b && h != f;
+      bool hf = h == f && d != h && b != f;
+      out[0][3 * x] = db ? d : e;
+      out[0][3 * x + 1] = (db && e != c) || (bf && e != a) ? b : e;
+      out[0][3 * x + 2] = bf ? f : e;
+      out[1][3 * x] = (db && e != g) || (dh && e != a) ? d : e;
+      out[1][3 * x + 1] = e;
+      out[1][3 * x + 2] = (bf && e != i) || (hf && e != c) ? f : e;
+      out[2][3 * x] = dh ? d : e;
+      out[2][3 * x + 1] = (dh && e != i) || (hf && e != g) ? h : e;
+      out[2][3 * x + 2] = hf ? f : e;
+    }
+  }
+}
+
+// Blocos factor x factor: cada linha da origem é ampliada uma vez num
+// buffer e copiada para as linhas do bloco. Com scanlines o último quarto
+// do bloco (pelo menos uma linha) sai com metade do brilho.
+static void expand_blocks(const Upscaler *upscaler, const uint32_t *src,
+                          int width, int height, int factor, bool scanlines,
+                          uint8_t *pixels, size_t pitch) {
+  int count = width * factor;
+  int dark = scanlines && factor >= 2 ? (factor >= 8 ? factor / 4 : 1) : 0;
+  uint32_t *bright = upscaler->lines;
+  uint32_t *dimmed = upscaler->lines + upscaler->line_capacity;
+  for (int y = 0; y < height; y++) {
+    uint8_t *block = pixels + (size_t)y * factor * pitch;
+    upscaler->expand_row(src + y * width, width, factor, bright);
+    if (dark > 0) {
+      upscaler->dim_row(bright, count, dimmed);
+    }
+    for (int r = 0; r < factor; r++) {
+      upscaler->copy_row(r < factor - dark ? bright : dimmed, count,
+                         (uint32_t *)(block + r * pitch));
+    }
+  }
+#ifdef UPSCALE_X86
+  // As gravações não temporárias ficam visíveis antes de a textura ser
+  // liberada para o renderizador
+  if (upscaler->copy_row != copy_row_scalar) {
+    store_fence();
+  }
+#endif
+}
+
+void upscaler_run(const Upscaler *upscaler, const Screen *screen,
+                  void *pixels, size_t pitch) {
+  int width = screen_width(screen);
+  int height = screen_height(screen);
+  int factor = upscaler_factor(upscaler, screen);
+  framebuffer_to_argb_native(screen, upscaler->source,
+                             (size_t)width * sizeof(uint32_t));
+
+  switch (upscaler->filter) {
+  case UPSCALE_SCALE2X:
+    scale2x(upscaler->source, width, height, upscaler->scratch);
+    expand_blocks(upscaler, upscaler->scratch, width * 2, height * 2,
+                  factor / 2, false, (uint8_t *)pixels, pitch);
+    break;
+  case UPSCALE_SCALE3X:
+    scale3x(upscaler->source, width, height, upscaler->scratch);
+    expand_blocks(upscaler, upscaler->scratch, width * 3, height * 3,
+                  factor / 3, false, (uint8_t *)pixels, pitch);
+    break;
+  default:
+    expand_blocks(upscaler, upscaler->source, width, height, factor,
+                  upscaler->filter == UPSCALE_CRT, (uint8_t *)pixels, pitch);
+  }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "screen.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Filtros de ampliação aplicados na CPU, direto na textura de streaming
+enum {
+  UPSCALE_NEAREST = 0, // Cada pixel vira um bloco inteiro
+  UPSCALE_SCALE2X,     // EPX/Scale2x e depois blocos inteiros
+  UPSCALE_SCALE3X,     // AdvMAME3x/Scale3x e depois blocos inteiros
+  UPSCALE_CRT,         // Blocos com o último quarto das linhas escurecido
+  UPSCALE_COUNT
+};
+
+// Núcleos da parte que escreve a saída inteira. Escolhidos uma vez em
+// upscaler_init: AVX2 ou SSE2 quando o processador tem, senão escalar.
+typedef void (*ExpandRow)(const uint32_t *src, int count, int factor,
+                          uint32_t *dst);
+typedef void (*DimRow)(const uint32_t *src, int count, uint32_t *dst);
+typedef void (*CopyRow)(const uint32_t *src, int count, uint32_t *dst);
+
+typedef struct {
+  int filter;
+  int max_width; // Área disponível para a imagem, em pixels
+  int max_height;
+  uint32_t *source;  // Tela em ARGB na resolução nativa
+  uint32_t *scratch; // Saída do Scale2x/Scale3x antes dos blocos
+  uint32_t *lines;   // Uma linha ampliada e a mesma escurecida
+  int line_capacity; // Pixels de cada uma
+  ExpandRow expand_row;
+  DimRow dim_row;
+  CopyRow copy_row; // Grava sem passar pelo cache: a saída não é relida
+  const char *kernel; // "avx2", "sse2" ou "scalar"
+} Upscaler;
+
+const char *upscale_filter_name(int filter);
+int upscale_filter_from_name(const char *name); // -1 se desconhecido
+
+bool upscaler_init(Upscaler *upscaler, int filter);
+void upscaler_free(Upscaler *upscaler);
+// Nova área disponível (ex.: a janela foi redimensionada). Se faltar
+// memória retorna false e mantém a área anterior.
+bool upscaler_resize(Upscaler *upscaler, int width, int height);
+// Fator inteiro usado para a tela na resolução atual: o maior que cabe na
+// área, múltiplo de 2 ou 3 para o Scale2x/Scale3x
+int upscaler_factor(const Upscaler *upscaler, const Screen *screen);
+// Tamanho da imagem gerada por upscaler_run para esta tela
+void upscaler_output_size(const Upscaler *upscaler, const Screen *screen,
+                          int *width, int *height);
+// Converte e amplia a tela em pixels (ARGB8888, pitch em bytes), que deve
+// ter pelo menos o tamanho de upscaler_output_size
+void upscaler_run(const Upscaler *upscaler, const Screen *screen,
+                  void *pixels, size_t pitch);
@@ -0,0 +1,320 @@
+// chip8-batch: roda milhares de ROMs independentes em todos os núcleos.
+//
+// Manifesto: uma tarefa por linha, "<rom> <ciclos> [script_de_entrada]".
+// Script de entrada: uma transição por linha, "<ciclo> <tecla_hex> <0|1>",
+// em ordem crescente de ciclo. Linhas vazias e iniciadas por '#' são
+// ignoradas nos dois formatos. Resultados saem em JSON, uma linha por tarefa,
+// na ordem do manifesto. Com --pack, <rom> é o nome da ROM dentro do pacote.
+#include "arena.h"
+#include "cpu.h"
+#include "jit.h"
+#include "pack.h"
+#include "sched.h"
+#include "pool.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  uint64_t cycle;
+  uint8_t key;
+  uint8_t down;
+} InputEvent;
+
+typedef struct {
+  char *rom;
+  char *script;
+  uint64_t budget;
+
+  // Resultado
+  bool ok;
+  uint64_t cycles;
+  uint64_t hash;
+  uint8_t v[NUM_REGISTERS];
+  uint16_t i;
+  uint16_t pc;
+} BatchJob;
+
+typedef struct {
+  BatchJob *jobs;
+  Scheduler sched;
+  bool use_jit;
+  RomPack pack;    // base == NULL: ROMs lidas do disco
+  CpuArena arena; // Uma instância por worker, reiniciada a cada tarefa
+} Batch;
+
+static char *dup_string(const char *text) {
+  char *copy = (char *)malloc(strlen(text) + 1);
+  if (copy) {
+    strcpy(copy, text);
+  }
+  return copy;
+}
+
+static bool skip_line(const char *line) {
+  while (*line == ' ' || *line == '\t') {
+    line++;
+  }
+  return *line == '#' || *line == '\n' || *line == '\r' || *line == '\0';
+}
+
+static InputEvent *load_script(const char *path, size_t *count) {
+  *count = 0;
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    perror("Erro ao abrir o script de entrada");
+    return NULL;
+  }
+
+  size_t capacity = 64;
+  InputEvent *events = (InputEvent *)malloc(capacity * sizeof(InputEvent));
+  char line[256];
+  while (events && fgets(line, sizeof(line), file)) {
+    if (skip_line(line)) {
+      continue;
+    }
+    unsigned long long cycle;
+    unsigned key, down;
+    if (sscanf(line, "%llu %x %u", &cycle, &key, &down) != 3 || key >= KEYS) {
+      fprintf(stderr, "Erro: Linha inválida em %s: %s", path, line);
+      continue;
+    }
+    if (*count == capacity) {
+      capacity *= 2;
+      InputEvent *grown =
+          (InputEvent *)realloc(events, capacity * sizeof(InputEvent));
+      if (grown == NULL) {
+        break;
+      }
+      events = grown;
+    }
+    events[(*count)++] = (InputEvent){cycle, (uint8_t)key, down != 0};
+  }
+  fclose(file);
+  return events;
+}
+
+static bool load_rom(const Batch *batch, const BatchJob *job, CPU *chip) {
+  if (batch->pack.base) {
+    // Direto dos bytes mapeados: nenhuma syscall nem alocação por ROM
+    const PackEntry *entry = pack_find(&batch->pack, job->rom);
+    if (entry == NULL) {
+      fprintf(stderr, "Erro: %s não está no pacote.\n", job->rom);
+      return false;
+    }
+    return initROMData(chip, pack_data(&batch->pack, entry), entry->size);
+  }
+
+  FILEDRAM *file = initFILE(job->rom);
+  if (file == NULL) {
+    return false;
+  }
+  bool ok = initROMData(chip, file->buffer, (size_t)file->size);
+  freeFILE(file);
+  return ok;
+}
+
+static void run_job(void *context, size_t index, int worker) {
+  Batch *batch = (Batch *)context;
+  BatchJob *job = &batch->jobs[index];
+
+  arena_reset(&batch->arena, worker);
+  CPU *chip = arena_get(&batch->arena, worker);
+  if (!load_rom(batch, job, chip)) {
+    return;
+  }
+  if (batch->use_jit && chip->jit == NULL) {
+    chip->jit = jit_create();
+  }
+
+  size_t event_count = 0;
+  InputEvent *events = NULL;
+  if (job->script) {
+    events = load_script(job->script, &event_count);
+  }
+
+  size_t next = 0;
+  while (chip->cycles < job->budget) {
+    while (next < event_count && events[next].cycle <= chip->cycles) {
+      chip->keys[events[next].key] = events[next].down;
+      next++;
+    }
+    uint64_t until = job->budget;
+    if (next < event_count && events[next].cycle < until) {
+      until = events[next].cycle;
+    }
+    run_cycles(chip, &batch->sched, until - chip->cycles);
+  }
+
+  job->cycles = chip->cycles;
+  job->hash = screen_hash(chip);
+  memcpy(job->v, chip->v, sizeof(job->v));
+  job->i = chip->i;
+  job->pc = chip->pc;
+  job->ok = true;
+
+  free(events);
+}
+
+static BatchJob *load_manifest(const char *path, size_t *count) {
+  *count = 0;
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    perror("Erro ao abrir o manifesto");
+    return NULL;
+  }
+
+  size_t capacity = 256;
+  BatchJob *jobs = (BatchJob *)calloc(capacity, sizeof(BatchJob));
+  char line[4096];
+  while (jobs && fgets(line, sizeof(line), file)) {
+    if (skip_line(line)) {
+      continue;
+    }
+    char rom[2048], script[2048];
+    unsigned long long budget;
+    int fields = sscanf(line, "%2047s %llu %2047s", rom, &budget, script);
+    if (fields < 2) {
+      fprintf(stderr, "Erro: Linha inválida no manifesto: %s", line);
+      continue;
+    }
+    if (*count == capacity) {
+      capacity *= 2;
+      BatchJob *grown = (BatchJob *)realloc(jobs, capacity * sizeof(BatchJob));
+      if (grown == NULL) {
+        break;
+      }
+      jobs = grown;
+    }
+    BatchJob *job = &jobs[(*count)++];
+    memset(job, 0, sizeof(*job));
+    job->rom = dup_string(rom);
+    job->script = fields == 3 ? dup_string(script) : NULL;
+    job->budget = budget;
+  }
+  fclose(file);
+  return jobs;
+}
+
+// String JSON: aspas, barra invertida e controles escapados
+static void print_json_string(FILE *out, const char *text) {
+  fputc('"', out);
+  for (const unsigned char *c = (const unsigned char *)text; *c; c++) {
+    if (*c == '"' || *c == '\\') {
+      fprintf(out, "\\%c", *c);
+    } else if (*c < 0x20) {
+      fprintf(out, "\\u%04x", *c);
+    } else {
+      fputc(*c, out);
+    }
+  }
+  fputc('"', out);
+}
+
+static void print_result(FILE *out, const BatchJob *job) {
+  fprintf(out, "{\"rom\": ");
+  print_json_string(out, job->rom);
+  fprintf(out, ", \"ok\": %s", job->ok ? "true" : "false");
+  if (job->ok) {
+    fprintf(out,
+            ", \"cycles\": %" PRIu64 ", \"hash\": \"%016" PRIx64 "\""
+            ", \"pc\": %u, \"i\": %u, \"v\": [",
+            job->cycles, job->hash, job->pc, job->i);
+    for (int r = 0; r < NUM_REGISTERS; r++) {
+      fprintf(out, "%u%s", job->v[r], r == NUM_REGISTERS - 1 ? "]" : ", ");
+    }
+  }
+  fprintf(out, "}\n");
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr, "Uso: %s [opções] <manifesto>\n", prog);
+  fprintf(stderr, "  --threads N  Número de workers (padrão: núcleos)\n");
+  fprintf(stderr, "  --ipf N      Instruções por frame (padrão: %d)\n",
+          DEFAULT_CYCLES_PER_FRAME);
+  fprintf(stderr, "  --jit        Usa o recompilador x86-64\n");
+  fprintf(stderr, "  --pack ARQ   Lê as ROMs de um pacote (ver chip8-pack)\n");
+  fprintf(stderr, "  --quirks P   Perfil: legacy (padrão), vip, chip48, schip,\n"
+                  "               xochip\n");
+}
+
+int main(int argc, char **argv) {
+  const char *manifest = NULL;
+  int workers = pool_default_workers();
+  const char *pack_path = NULL;
+  int quirks = QUIRKS_LEGACY;
+  Batch batch = {0};
+  initScheduler(&batch.sched);
+  batch.sched.turbo = true;
+
+  for (int a = 1; a < argc; a++) {
+    if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc) {
+      workers = atoi(argv[++a]);
+    } else if (strcmp(argv[a], "--ipf") == 0 && a + 1 < argc) {
+      int ipf = atoi(argv[++a]);
+      if (ipf <= 0) {
+        fprintf(stderr, "Erro: Valor inválido para --ipf: %s\n", argv[a]);
+        return -1;
+      }
+      batch.sched.cycles_per_frame = (uint32_t)ipf;
+    } else if (strcmp(argv[a], "--jit") == 0) {
+      batch.use_jit = true;
+    } else if (strcmp(argv[a], "--pack") == 0 && a + 1 < argc) {
+      pack_path = argv[++a];
+    } else if (strcmp(argv[a], "--quirks") == 0 && a + 1 < argc) {
+      quirks = quirks_from_name(argv[++a]);
+      if (quirks < 0) {
+        fprintf(stderr, "Erro: Perfil desconhecido: %s\n", argv[a]);
+        return -1;
+      }
+    } else if (argv[a][0] == '-' && argv[a][1] == '-') {
+      usage(argv[0]);
+      return -1;
+    } else {
+      manifest = argv[a];
+    }
+  }
+  if (manifest == NULL) {
+    usage(argv[0]);
+    return -1;
+  }
+
+  if (pack_path && !pack_open(&batch.pack, pack_path)) {
+    return -1;
+  }
+  if (workers < 1) {
+    workers = 1;
+  }
+  if (!arena_init(&batch.arena, (size_t)workers)) {
+    return -1;
+  }
+  for (int w = 0; w < workers; w++) {
+    set_quirks(arena_get(&batch.arena, w), (uint8_t)quirks);
+  }
+
+  size_t count;
+  batch.jobs = load_manifest(manifest, &count);
+  if (batch.jobs == NULL) {
+    return -1;
+  }
+
+  if (pool_run(workers, count, run_job, &batch) != 0) {
+    return -1;
+  }
+  pack_close(&batch.pack);
+  arena_free(&batch.arena);
+
+  int failed = 0;
+  for (size_t j = 0; j < count; j++) {
+    print_result(stdout, &batch.jobs[j]);
+    failed += !batch.jobs[j].ok;
+    free(batch.jobs[j].rom);
+    free(batch.jobs[j].script);
+  }
+  free(batch.jobs);
+  if (failed) {
+    fprintf(stderr, "%d de %zu tarefas falharam.\n", failed, count);
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,521 @@
+// chip8-fuzz: explora o espaço de estados de uma ROM procurando entradas de
+// teclado que levam a falhas do programa (pilha estourada, sprite ou
+// gravação além do fim da memória, opcode desconhecido).
+//
+// Cada item do corpus guarda o estado da CPU no fim da sua execução. Um
+// candidato novo parte de um desses estados (load_state, sem repetir nada
+// desde o reset) e roda um segmento de alguns frames com uma sequência de
+// teclas mutada. Se o segmento cobre arestas novas vira item do corpus;
+// se termina em falha, a sequência inteira desde o reset é gravada como
+// uma gravação (--replay) que reproduz a falha. Os workers compartilham o
+// corpus e o mapa de cobertura.
+#include "arena.h"
+#include "emu.h"
+#include "idle.h"
+#include "pack.h"
+#include "pool.h"
+#include "replay.h"
+#include "sched.h"
+#include "state.h"
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FUZZ_MAX_CORPUS 4096
+#define FUZZ_MAX_EVENTS 16     // Transições de tecla por segmento
+#define FUZZ_DEFAULT_SEGMENT 60 // Frames por execução (1 s do convidado)
+#define FUZZ_MAX_CRASHES 256
+#define FUZZ_CHECK_EXECS 256 // Execuções entre consultas ao relógio
+
+typedef struct {
+  uint16_t frame; // Frame do segmento em que a transição acontece
+  uint8_t key;
+  uint8_t down;
+} FuzzEvent;
+
+typedef struct FuzzEntry {
+  const struct FuzzEntry *parent; // NULL: estado logo depois do reset
+  uint64_t start_cycle;           // Início do segmento (fim do pai)
+  uint32_t depth;
+  uint8_t event_count;
+  FuzzEvent events[FUZZ_MAX_EVENTS];
+  SaveState state; // Estado no fim do segmento
+} FuzzEntry;
+
+typedef struct {
+  uint8_t fault;
+  uint16_t pc;
+} FuzzCrash;
+
+typedef struct {
+  CpuArena arena; // Uma CPU por worker e, na última posição, a do reset
+  const CPU *root;
+  Scheduler sched;
+  uint32_t segment;
+  double seconds;
+  uint64_t max_execs;
+  const char *out_dir;
+  uint64_t rom_hash;
+  double start;
+
+  // Itens são publicados com release em corpus_count e nunca mudam depois
+  FuzzEntry *corpus[FUZZ_MAX_CORPUS];
+  atomic_size_t corpus_count;
+
+  pthread_mutex_t lock; // Protege virgin, edges e crashes
+  uint8_t virgin[COVERAGE_MAP_SIZE]; // Classes de contagem já vistas
+  size_t edges;
+  FuzzCrash crashes[FUZZ_MAX_CRASHES];
+  size_t crash_count;
+
+  atomic_uint_fast64_t execs;
+  atomic_uint_fast64_t instructions;
+  atomic_bool stop;
+} Fuzzer;
+
+// Classes de contagem do AFL: 1, 2, 3, 4-7, 8-15, 16-31, 32-127, 128+
+static uint8_t count_class[256];
+
+static void init_count_class(void) {
+  for (int c = 0; c < 256; c++) {
+    count_class[c] = c == 0    ? 0
+                     : c == 1  ? 1
+                     : c == 2  ? 2
+                     : c == 3  ? 4
+                     : c < 8   ? 8
+                     : c < 16  ? 16
+                     : c < 32  ? 32
+                     : c < 128 ? 64
+                               : 128;
+  }
+}
+
+static double now_seconds(void) {
+  struct timespec now;
+  timespec_get(&now, TIME_UTC);
+  return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+// xorshift64*: um gerador por worker
+static uint64_t next_random(uint64_t *state) {
+  uint64_t x = *state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+  return x * 0x2545F4914F6CDD1Dull;
+}
+
+static uint32_t random_below(uint64_t *state, uint32_t bound) {
+  return (uint32_t)((next_random(state) >> 32) * bound >> 32);
+}
+
+// Um toque: aperta e solta a mesma tecla alguns frames depois
+static void add_tap(FuzzEntry *child, uint32_t segment, uint64_t *rng) {
+  if (child->event_count + 2 > FUZZ_MAX_EVENTS) {
+    return;
+  }
+  uint8_t key = (uint8_t)random_below(rng, KEYS);
+  uint16_t press = (uint16_t)random_below(rng, segment);
+  uint16_t release = (uint16_t)(press + 1 + random_below(rng, segment));
+  child->events[child->event_count++] = (FuzzEvent){press, key, 1};
+  if (release < segment) {
+    child->events[child->event_count++] = (FuzzEvent){release, key, 0};
+  }
+}
+
+static void sort_events(FuzzEntry *child) {
+  for (int a = 1; a < child->event_count; a++) {
+    FuzzEvent event = child->events[a];
+    int b = a;
+    while (b > 0 && child->events[b - 1].frame > event.frame) {
+      child->events[b] = child->events[b - 1];
+      b--;
+    }
+    child->events[b] = event;
+  }
+}
+
+// Metade das vezes uma sequência nova de toques; na outra, a sequência do
+// pai com algumas mutações pontuais
+static void mutate(const FuzzEntry *parent, FuzzEntry *child,
+                   uint32_t segment, uint64_t *rng) {
+  child->event_count = 0;
+  if (random_below(rng, 2) == 0 || parent->event_count == 0) {
+    uint32_t taps = random_below(rng, FUZZ_MAX_EVENTS / 2 + 1);
+    for (uint32_t t = 0; t < taps; t++) {
+      add_tap(child, segment, rng);
+    }
+  } else {
+    child->event_count = parent->event_count;
+    memcpy(child->events, parent->events,
+           parent->event_count * sizeof(FuzzEvent));
+    uint32_t rounds = 1 + random_below(rng, 3);
+    for (uint32_t r = 0; r < rounds; r++) {
+      FuzzEvent *event = child->event_count
+                             ? &child->events[random_below(
+                                   rng, child->event_count)]
+                             : NULL;
+      switch (random_below(rng, 5)) {
+      case 0:
+        if (event) {
+          event->frame = (uint16_t)random_below(rng, segment);
+        }
+        break;
+      case 1:
+        if (event) {
+          event->key = (uint8_t)random_below(rng, KEYS);
+        }
+        break;
+      case 2:
+        if (event) {
+          event->down ^= 1;
+        }
+        break;
+      case 3:
+        if (event) {
+          *event = child->events[--child->event_count];
+        }
+        break;
+      default:
+        add_tap(child, segment, rng);
+      }
+    }
+  }
+  sort_events(child);
+}
+
+// Roda o segmento a partir do estado já carregado. Retorna as instruções
+// executadas; para na primeira falha.
+static uint64_t run_segment(const Fuzzer *fuzz, CPU *chip,
+                            const FuzzEntry *child, uint8_t *edges) {
+  uint32_t ipf = fuzz->sched.cycles_per_frame;
+  uint64_t executed = 0;
+  int next = 0;
+  for (uint32_t frame = 0; frame < fuzz->segment; frame++) {
+    while (next < child->event_count && child->events[next].frame == frame) {
+      chip->keys[child->events[next].key] = child->events[next].down;
+      next++;
+    }
+    // CPU parada esperando tecla: nada muda até a próxima transição
+    if (idle_halted(chip)) {
+      uint32_t until =
+          next < child->event_count ? child->events[next].frame : fuzz->segment;
+      chip->cycles += (uint64_t)(until - frame) * ipf;
+      frame = until - 1;
+      continue;
+    }
+    uint64_t done = chip->interp->cover(chip, ipf, edges);
+    chip->cycles += done;
+    executed += done;
+    if (chip->fault != FAULT_NONE) {
+      break;
+    }
+    tick_timers(chip);
+  }
+  return executed;
+}
+
+// Classifica as contagens e diz se alguma classe ainda não foi vista
+static bool classify_edges(uint8_t *edges, const uint8_t *seen) {
+  bool fresh = false;
+  for (size_t at = 0; at < COVERAGE_MAP_SIZE; at += 8) {
+    uint64_t word;
+    memcpy(&word, edges + at, sizeof(word));
+    if (word == 0) {
+      continue;
+    }
+    uint64_t classes = 0;
+    for (int b = 0; b < 8; b++) {
+      classes |= (uint64_t)count_class[(word >> (8 * b)) & 0xFF] << (8 * b);
+    }
+    uint64_t known;
+    memcpy(&known, seen + at, sizeof(known));
+    memcpy(edges + at, &classes, sizeof(classes));
+    fresh |= (classes & ~known) != 0;
+  }
+  return fresh;
+}
+
+// Com o lock: junta ao mapa global; true se havia algo novo de fato
+static bool merge_edges(Fuzzer *fuzz, const uint8_t *edges) {
+  bool fresh = false;
+  for (size_t e = 0; e < COVERAGE_MAP_SIZE; e++) {
+    uint8_t added = edges[e] & ~fuzz->virgin[e];
+    if (added) {
+      fuzz->edges += fuzz->virgin[e] == 0;
+      fuzz->virgin[e] |= added;
+      fresh = true;
+    }
+  }
+  return fresh;
+}
+
+// Grava a sequência inteira desde o reset no formato do --replay
+static void write_crash(const Fuzzer *fuzz, const FuzzEntry *child,
+                        const CPU *chip) {
+  char path[1024];
+  snprintf(path, sizeof(path), "%s/crash-%s-%03X.c8r", fuzz->out_dir,
+           fault_name(chip->fault), chip->fault_pc);
+
+  // Os ancestrais vêm do mais novo para o mais antigo
+  const FuzzEntry **chain =
+      (const FuzzEntry **)malloc((child->depth + 1) * sizeof(FuzzEntry *));
+  if (chain == NULL) {
+    return;
+  }
+  uint32_t length = 0;
+  for (const FuzzEntry *at = child; at != NULL; at = at->parent) {
+    chain[length++] = at;
+  }
+
+  Recorder recorder;
+  if (recorder_open(&recorder, path, fuzz->root, &fuzz->sched,
+                    fuzz->rom_hash)) {
+    uint32_t ipf = fuzz->sched.cycles_per_frame;
+    for (uint32_t n = length; n-- > 0;) {
+      const FuzzEntry *entry = chain[n];
+      for (int e = 0; e < entry->event_count; e++) {
+        uint64_t cycle = entry->start_cycle + (uint64_t)entry->events[e].frame * ipf;
+        if (cycle <= chip->cycles) {
+          recorder_key(&recorder, cycle, entry->events[e].key,
+                       entry->events[e].down);
+        }
+      }
+    }
+    recorder_close(&recorder, chip->cycles);
+    printf("Falha nova: %s em 0x%03X no ciclo %" PRIu64 " -> %s\n",
+           fault_name(chip->fault), chip->fault_pc, chip->cycles, path);
+  }
+  free(chain);
+}
+
+static void report_crash(Fuzzer *fuzz, const FuzzEntry *child,
+                         const CPU *chip) {
+  pthread_mutex_lock(&fuzz->lock);
+  bool known = false;
+  for (size_t c = 0; c < fuzz->crash_count && !known; c++) {
+    known = fuzz->crashes[c].fault == chip->fault &&
+            fuzz->crashes[c].pc == chip->fault_pc;
+  }
+  if (!known && fuzz->crash_count < FUZZ_MAX_CRASHES) {
+    fuzz->crashes[fuzz->crash_count++] = (FuzzCrash){chip->fault, chip->fault_pc};
+    write_crash(fuzz, child, chip);
+  }
+  pthread_mutex_unlock(&fuzz->lock);
+}
+
+static void print_stats(Fuzzer *fuzz, double elapsed) {
+  uint64_t execs = atomic_load(&fuzz->execs);
+  uint64_t instructions = atomic_load(&fuzz->instructions);
+  pthread_mutex_lock(&fuzz->lock);
+  size_t edges = fuzz->edges;
+  size_t crashes = fuzz->crash_count;
+  pthread_mutex_unlock(&fuzz->lock);
+  printf("%.0f s: %" PRIu64 " execuções (%.0f/s), %.1f MIPS, corpus %zu, "
+         "arestas %zu, falhas %zu\n",
+         elapsed, execs, elapsed > 0 ? execs / elapsed : 0.0,
+         elapsed > 0 ? instructions / elapsed / 1e6 : 0.0,
+         atomic_load(&fuzz->corpus_count), edges, crashes);
+  fflush(stdout);
+}
+
+static void fuzz_worker(void *context, size_t job, int worker) {
+  Fuzzer *fuzz = (Fuzzer *)context;
+  CPU *chip = arena_get(&fuzz->arena, (size_t)worker);
+  uint64_t rng = 0x9E3779B97F4A7C15ull * (job + 1);
+  uint8_t edges[COVERAGE_MAP_SIZE];
+  uint8_t seen[COVERAGE_MAP_SIZE]; // Cópia local de virgin, sem lock
+  memset(seen, 0, sizeof(seen));
+  FuzzEntry *child = (FuzzEntry *)malloc(sizeof(FuzzEntry));
+  double last_report = fuzz->start;
+  uint64_t execs = 0;
+  uint64_t instructions = 0;
+
+  while (child && !atomic_load_explicit(&fuzz->stop, memory_order_relaxed)) {
+    size_t count = atomic_load_explicit(&fuzz->corpus_count,
+                                        memory_order_acquire);
+    // Metade das escolhas favorece os itens mais recentes (mais fundos)
+    size_t pick = random_below(&rng, (uint32_t)count);
+    if (random_below(&rng, 2) == 0) {
+      pick = count - 1 - random_below(&rng, (uint32_t)(count < 16 ? count : 16));
+    }
+    const FuzzEntry *parent = fuzz->corpus[pick];
+    load_state(chip, &parent->state);
+    mutate(parent, child, fuzz->segment, &rng);
+    child->parent = parent;
+    child->start_cycle = chip->cycles;
+    child->depth = parent->depth + 1;
+
+    memset(edges, 0, sizeof(edges));
+    instructions += run_segment(fuzz, chip, child, edges);
+    execs++;
+
+    if (chip->fault != FAULT_NONE) {
+      report_crash(fuzz, child, chip);
+    } else if (classify_edges(edges, seen)) {
+      pthread_mutex_lock(&fuzz->lock);
+      size_t index = atomic_load_explicit(&fuzz->corpus_count,
+                                          memory_order_relaxed);
+      if (merge_edges(fuzz, edges) && index < FUZZ_MAX_CORPUS) {
+        save_state(chip, &child->state);
+        fuzz->corpus[index] = child;
+        atomic_store_explicit(&fuzz->corpus_count, index + 1,
+                              memory_order_release);
+        child = (FuzzEntry *)malloc(sizeof(FuzzEntry));
+      }
+      memcpy(seen, fuzz->virgin, sizeof(seen));
+      pthread_mutex_unlock(&fuzz->lock);
+    }
+
+    if (execs % FUZZ_CHECK_EXECS == 0) {
+      atomic_fetch_add(&fuzz->execs, execs);
+      atomic_fetch_add(&fuzz->instructions, instructions);
+      execs = instructions = 0;
+      double now = now_seconds();
+      if ((fuzz->seconds > 0 && now - fuzz->start >= fuzz->seconds) ||
+          (fuzz->max_execs && atomic_load(&fuzz->execs) >= fuzz->max_execs)) {
+        atomic_store(&fuzz->stop, true);
+      }
+      if (job == 0 && now - last_report >= 1.0) {
+        print_stats(fuzz, now - fuzz->start);
+        last_report = now;
+      }
+    }
+  }
+  atomic_fetch_add(&fuzz->execs, execs);
+  atomic_fetch_add(&fuzz->instructions, instructions);
+  if (child == NULL) {
+    fprintf(stderr, "Erro: Falha ao alocar um item do corpus.\n");
+    atomic_store(&fuzz->stop, true);
+  }
+  free(child);
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr, "Uso: %s [opções] <rom>\n", prog);
+  fprintf(stderr, "  --threads N  Número de workers (padrão: núcleos)\n");
+  fprintf(stderr, "  --ipf N      Instruções por frame (padrão: %d)\n",
+          DEFAULT_CYCLES_PER_FRAME);
+  fprintf(stderr, "  --quirks P   Perfil: legacy (padrão), vip, chip48, schip,\n"
+                  "               xochip\n");
+  fprintf(stderr, "  --seed N     Semente do gerador do CXNN\n");
+  fprintf(stderr, "  --segment N  Frames por execução (padrão: %d)\n",
+          FUZZ_DEFAULT_SEGMENT);
+  fprintf(stderr, "  --time S     Duração em segundos (padrão: 10, 0 = sem "
+                  "limite)\n");
+  fprintf(stderr, "  --execs N    Para depois de N execuções\n");
+  fprintf(stderr, "  --out DIR    Onde gravar as falhas (padrão: .)\n");
+}
+
+int main(int argc, char **argv) {
+  const char *rom_path = NULL;
+  int workers = pool_default_workers();
+  int quirks = QUIRKS_LEGACY;
+  unsigned long seed = 0;
+  static Fuzzer fuzz;
+  initScheduler(&fuzz.sched);
+  fuzz.segment = FUZZ_DEFAULT_SEGMENT;
+  fuzz.seconds = 10;
+  fuzz.out_dir = ".";
+
+  for (int a = 1; a < argc; a++) {
+    if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc) {
+      workers = atoi(argv[++a]);
+    } else if (strcmp(argv[a], "--ipf") == 0 && a + 1 < argc) {
+      int ipf = atoi(argv[++a]);
+      if (ipf <= 0) {
+        fprintf(stderr, "Erro: Valor inválido para --ipf: %s\n", argv[a]);
+        return -1;
+      }
+      fuzz.sched.cycles_per_frame = (uint32_t)ipf;
+    } else if (strcmp(argv[a], "--quirks") == 0 && a + 1 < argc) {
+      quirks = quirks_from_name(argv[++a]);
+      if (quirks < 0) {
+        fprintf(stderr, "Erro: Perfil desconhecido: %s\n", argv[a]);
+        return -1;
+      }
+    } else if (strcmp(argv[a], "--seed") == 0 && a + 1 < argc) {
+      seed = strtoul(argv[++a], NULL, 0);
+    } else if (strcmp(argv[a], "--segment") == 0 && a + 1 < argc) {
+      int segment = atoi(argv[++a]);
+      if (segment <= 0 || segment > UINT16_MAX) {
+        fprintf(stderr, "Erro: Valor inválido para --segment: %s\n", argv[a]);
+        return -1;
+      }
+      fuzz.segment = (uint32_t)segment;
+    } else if (strcmp(argv[a], "--time") == 0 && a + 1 < argc) {
+      fuzz.seconds = atof(argv[++a]);
+    } else if (strcmp(argv[a], "--execs") == 0 && a + 1 < argc) {
+      fuzz.max_execs = strtoull(argv[++a], NULL, 0);
+    } else if (strcmp(argv[a], "--out") == 0 && a + 1 < argc) {
+      fuzz.out_dir = argv[++a];
+    } else if (argv[a][0] == '-' && argv[a][1] == '-') {
+      usage(argv[0]);
+      return -1;
+    } else {
+      rom_path = argv[a];
+    }
+  }
+  if (rom_path == NULL) {
+    usage(argv[0]);
+    return -1;
+  }
+  if (workers < 1) {
+    workers = 1;
+  }
+
+  init_count_class();
+  if (!arena_init(&fuzz.arena, (size_t)workers + 1)) {
+    return -1;
+  }
+  for (int w = 0; w <= workers; w++) {
+    set_quirks(arena_get(&fuzz.arena, w), (uint8_t)quirks);
+  }
+
+  // Estado do reset: raiz do corpus e cabeçalho das gravações de falha
+  CPU *root = arena_get(&fuzz.arena, (size_t)workers);
+  FILEDRAM *file = initFILE(rom_path);
+  if (file == NULL) {
+    return -1;
+  }
+  bool loaded = initROMData(root, file->buffer, (size_t)file->size);
+  fuzz.rom_hash = pack_hash(file->buffer, (size_t)file->size);
+  freeFILE(file);
+  if (!loaded) {
+    return -1;
+  }
+  if (seed) {
+    seedCPU(root, (uint32_t)seed);
+  }
+  fuzz.root = root;
+  FuzzEntry *first = (FuzzEntry *)calloc(1, sizeof(FuzzEntry));
+  if (first == NULL) {
+    fprintf(stderr, "Erro: Falha ao alocar o corpus.\n");
+    return -1;
+  }
+  save_state(root, &first->state);
+  fuzz.corpus[0] = first;
+  atomic_init(&fuzz.corpus_count, 1);
+  atomic_init(&fuzz.execs, 0);
+  atomic_init(&fuzz.instructions, 0);
+  atomic_init(&fuzz.stop, false);
+  pthread_mutex_init(&fuzz.lock, NULL);
+
+  fuzz.start = now_seconds();
+  if (pool_run(workers, (size_t)workers, fuzz_worker, &fuzz) != 0) {
+    return -1;
+  }
+  print_stats(&fuzz, now_seconds() - fuzz.start);
+
+  size_t corpus = atomic_load(&fuzz.corpus_count);
+  for (size_t n = 0; n < corpus; n++) {
+    free(fuzz.corpus[n]);
+  }
+  pthread_mutex_destroy(&fuzz.lock);
+  arena_free(&fuzz.arena);
+  return fuzz.crash_count ? 1 : 0;
+}
@@ -0,0 +1,144 @@
+// chip8-pack: junta as ROMs de um diretório em um pacote (ver src/pack.h).
+//
+// Uso: chip8-pack <diretório> <saída>
+// Arquivos com nome longo demais ou maiores que a memória livre do Chip-8
+// são ignorados com um aviso.
+#include "cpu.h"
+#include "pack.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+typedef struct {
+  char name[PACK_NAME_SIZE];
+  uint8_t *data;
+  uint32_t size;
+} PackInput;
+
+static int compare_inputs(const void *a, const void *b) {
+  return strcmp(((const PackInput *)a)->name, ((const PackInput *)b)->name);
+}
+
+static uint8_t *read_rom(const char *path, uint32_t *size) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    perror(path);
+    return NULL;
+  }
+  uint8_t *data = (uint8_t *)malloc(MEMORY_SIZE);
+  size_t read = data ? fread(data, 1, MEMORY_SIZE, file) : 0;
+  fclose(file);
+  if (data == NULL || read > MEMORY_SIZE - ROM_START_ADDRESS) {
+    fprintf(stderr, "Aviso: %s ignorado (grande demais).\n", path);
+    free(data);
+    return NULL;
+  }
+  *size = (uint32_t)read;
+  return data;
+}
+
+static PackInput *scan_directory(const char *dir_path, uint32_t *count) {
+  *count = 0;
+  DIR *dir = opendir(dir_path);
+  if (dir == NULL) {
+    perror("Erro ao abrir o diretório");
+    return NULL;
+  }
+
+  size_t capacity = 256;
+  PackInput *inputs = (PackInput *)malloc(capacity * sizeof(PackInput));
+  struct dirent *item;
+  char path[4096];
+  while (inputs && (item = readdir(dir)) != NULL) {
+    snprintf(path, sizeof(path), "%s/%s", dir_path, item->d_name);
+    struct stat info;
+    if (stat(path, &info) != 0 || !S_ISREG(info.st_mode)) {
+      continue;
+    }
+    if (strlen(item->d_name) >= PACK_NAME_SIZE) {
+      fprintf(stderr, "Aviso: %s ignorado (nome longo demais).\n", path);
+      continue;
+    }
+    if (*count == capacity) {
+      capacity *= 2;
+      PackInput *grown =
+          (PackInput *)realloc(inputs, capacity * sizeof(PackInput));
+      if (grown == NULL) {
+        break;
+      }
+      inputs = grown;
+    }
+    PackInput *input = &inputs[*count];
+    input->data = read_rom(path, &input->size);
+    if (input->data == NULL) {
+      continue;
+    }
+    memset(input->name, 0, sizeof(input->name));
+    strcpy(input->name, item->d_name);
+    (*count)++;
+  }
+  closedir(dir);
+
+  if (inputs) {
+    qsort(inputs, *count, sizeof(PackInput), compare_inputs);
+  }
+  return inputs;
+}
+
+static bool write_pack(const char *path, const PackInput *inputs,
+                       uint32_t count) {
+  FILE *out = fopen(path, "wb");
+  if (out == NULL) {
+    perror("Erro ao criar o pacote");
+    return false;
+  }
+
+  PackHeader header = {PACK_MAGIC, PACK_VERSION, 0, count, 0};
+  bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+
+  uint32_t offset = sizeof(PackHeader) + count * sizeof(PackEntry);
+  for (uint32_t n = 0; ok && n < count; n++) {
+    PackEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    memcpy(entry.name, inputs[n].name, PACK_NAME_SIZE);
+    entry.hash = pack_hash(inputs[n].data, inputs[n].size);
+    entry.offset = offset;
+    entry.size = inputs[n].size;
+    ok = fwrite(&entry, sizeof(entry), 1, out) == 1;
+    offset += inputs[n].size;
+  }
+  for (uint32_t n = 0; ok && n < count; n++) {
+    ok = fwrite(inputs[n].data, 1, inputs[n].size, out) == inputs[n].size;
+  }
+
+  if (fclose(out) != 0 || !ok) {
+    fprintf(stderr, "Erro: Falha ao gravar %s.\n", path);
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    fprintf(stderr, "Uso: %s <diretório> <saída>\n", argv[0]);
+    return -1;
+  }
+
+  uint32_t count;
+  PackInput *inputs = scan_directory(argv[1], &count);
+  if (inputs == NULL) {
+    return -1;
+  }
+  bool ok = write_pack(argv[2], inputs, count);
+  if (ok) {
+    fprintf(stderr, "%u ROMs gravadas em %s.\n", count, argv[2]);
+  }
+
+  for (uint32_t n = 0; n < count; n++) {
+    free(inputs[n].data);
+  }
+  free(inputs);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+#include "pool.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct {
+  Pool *pool;
+  int id;
+} PoolWorker;
+
+int pool_default_workers(void) {
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  return cores > 0 ? (int)cores : 1;
+}
+
+static bool pop_own(PoolDeque *deque, size_t *job) {
+  bool found = false;
+  pthread_mutex_lock(&deque->lock);
+  if (deque->tail > deque->head) {
+    *job = deque->jobs[--deque->tail];
+    found = true;
+  }
+  pthread_mutex_unlock(&deque->lock);
+  return found;
+}
+
+static bool steal(PoolDeque *deque, size_t *job) {
+  bool found = false;
+  // Não disputa o lock com quem já está mexendo no deque
+  if (pthread_mutex_trylock(&deque->lock) != 0) {
+    return false;
+  }
+  if (deque->tail > deque->head) {
+    *job = deque->jobs[deque->head++];
+    found = true;
+  }
+  pthread_mutex_unlock(&deque->lock);
+  return found;
+}
+
+static bool any_work_left(Pool *pool) {
+  for (int w = 0; w < pool->workers; w++) {
+    PoolDeque *deque = &pool->deques[w];
+    pthread_mutex_lock(&deque->lock);
+    bool left = deque->tail > deque->head;
+    pthread_mutex_unlock(&deque->lock);
+    if (left) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void *worker_main(void *arg) {
+  PoolWorker *self = (PoolWorker *)arg;
+  Pool *pool = self->pool;
+  size_t job;
+
+  for (;;) {
+    if (pop_own(&pool->deques[self->id], &job)) {
+      pool->task(pool->context, job, self->id);
+      continue;
+    }
+    bool stolen = false;
+    for (int n = 1; n < pool->workers && !stolen; n++) {
+      int victim = (self->id + n) % pool->workers;
+      stolen = steal(&pool->deques[victim], &job);
+    }
+    if (stolen) {
+      pool->task(pool->context, job, self->id);
+    } else if (!any_work_left(pool)) {
+      // As tarefas não geram novas tarefas: deques vazios = fim
+      break;
+    }
+  }
+  return NULL;
+}
+
+static void free_deques(Pool *pool) {
+  for (int w = 0; w < pool->workers; w++) {
+    pthread_mutex_destroy(&pool->deques[w].lock);
+    free(pool->deques[w].jobs);
+  }
+  free(pool->deques);
+}
+
+int pool_run(int workers, size_t jobs, PoolTask task, void *context) {
+  if (workers < 1) {
+    workers = 1;
+  }
+  Pool pool = {workers, NULL, task, context};
+  pool.deques = (PoolDeque *)calloc(workers, sizeof(PoolDeque));
+  PoolWorker *threads = (PoolWorker *)calloc(workers, sizeof(PoolWorker));
+  pthread_t *ids = (pthread_t *)calloc(workers, sizeof(pthread_t));
+  if (!pool.deques || !threads || !ids) {
+    fprintf(stderr, "Erro: Falha ao alocar o pool de threads.\n");
+    free(pool.deques);
+    free(threads);
+    free(ids);
+    return -1;
+  }
+
+  // Distribuição inicial round-robin; o roubo equilibra o resto
+  bool allocated = true;
+  for (int w = 0; w < workers; w++) {
+    PoolDeque *deque = &pool.deques[w];
+    pthread_mutex_init(&deque->lock, NULL);
+    deque->jobs = (size_t *)malloc((jobs / workers + 1) * sizeof(size_t));
+    allocated = allocated && deque->jobs != NULL;
+  }
+  if (!allocated) {
+    fprintf(stderr, "Erro: Falha ao alocar as filas do pool de threads.\n");
+    free_deques(&pool);
+    free(threads);
+    free(ids);
+    return -1;
+  }
+  for (size_t j = 0; j < jobs; j++) {
+    PoolDeque *deque = &pool.deques[j % workers];
+    deque->jobs[deque->tail++] = j;
+  }
+
+  int started = 0;
+  for (int w = 0; w < workers; w++) {
+    threads[w].pool = &pool;
+    threads[w].id = w;
+    if (pthread_create(&ids[w], NULL, worker_main, &threads[w]) != 0) {
+      break;
+    }
+    started++;
+  }
+  if (started == 0) {
+    // Sem threads: roda tudo na thread atual
+    threads[0].pool = &pool;
+    threads[0].id = 0;
+    worker_main(&threads[0]);
+  }
+  for (int w = 0; w < started; w++) {
+    pthread_join(ids[w], NULL);
+  }
+
+  free_deques(&pool);
+  free(threads);
+  free(ids);
+  return 0;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Pool de threads com roubo de trabalho: cada worker tem seu próprio deque
+// de tarefas; consome pelo fim e, quando esvazia, rouba do início dos deques
+// dos outros workers.
+typedef void (*PoolTask)(void *context, size_t job, int worker);
+
+typedef struct {
+  pthread_mutex_t lock;
+  size_t *jobs;
+  size_t head; // Roubos saem daqui
+  size_t tail; // O dono empilha e desempilha aqui
+} PoolDeque;
+
+typedef struct {
+  int workers;
+  PoolDeque *deques;
+  PoolTask task;
+  void *context;
+} Pool;
+
+int pool_default_workers(void);
+int pool_run(int workers, size_t jobs, PoolTask task, void *context);
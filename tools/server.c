@@ -0,0 +1,549 @@
+// chip8-server: roda sessões sem janela e transmite a tela para clientes
+// num socket Unix (protocolo em server.h).
+//
+// Uma única thread atende todas as conexões com epoll; um timerfd de 60 Hz
+// avança o frame de cada sessão. Só as linhas que mudaram desde o último
+// frame confirmado pelo cliente são enviadas, codificadas com delta.h, e uma
+// sessão parada (tela igual à do último envio) não gera tráfego. Como cada
+// frame custa cycles_per_frame instruções, centenas de sessões cabem em um
+// núcleo.
+#define _GNU_SOURCE // accept4
+#include "arena.h"
+#include "keymap.h"
+#include "quirks.h"
+#include "sched.h"
+#include "server.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define SERVER_DEFAULT_SOCKET "chip8.sock"
+#define SERVER_DEFAULT_SESSIONS 256
+#define SERVER_HISTORY (SERVER_MAX_INFLIGHT + 1)
+#define SERVER_MAX_CATCHUP 4 // Frames por tick quando o timer atrasa
+#define SERVER_EVENTS 64
+#define SERVER_MAX_ROM (MEMORY_SIZE - ROM_START_ADDRESS)
+#define SERVER_IN_SIZE (SERVER_LOAD_HEADER + SERVER_MAX_ROM)
+#define SERVER_OUT_SIZE                                                       \
+  (SERVER_MAX_INFLIGHT * (SERVER_FRAME_HEADER + DELTA_MAX_SIZE))
+
+typedef struct Session {
+  int fd;
+  struct Session *next;
+  CPU *chip;
+  bool loaded;  // Tem ROM (a padrão ou uma enviada com LOAD)
+  bool dirty;   // draw_flag desde o último envio
+  bool closing; // Liberada no fim da rodada de eventos
+  bool writing; // Esperando EPOLLOUT
+  uint32_t sent;  // seq do último frame enviado
+  uint32_t acked; // seq do último frame confirmado: a base do próximo
+  Screen history[SERVER_HISTORY]; // Frames desde acked, por seq % HISTORY
+  uint8_t in[SERVER_IN_SIZE];
+  size_t in_len;
+  uint8_t out[SERVER_OUT_SIZE];
+  size_t out_start;
+  size_t out_len;
+} Session;
+
+typedef struct {
+  int epoll;
+  int listener;
+  int timer;
+  Scheduler sched;
+  uint8_t quirks;
+  const uint8_t *rom; // ROM padrão das sessões novas (NULL = esperar LOAD)
+  size_t rom_size;
+  Session *sessions;
+  size_t session_count;
+  size_t max_sessions;
+  uint64_t served;
+  uint64_t frames;
+  uint64_t bytes;
+} Server;
+
+// Marcadores de data.ptr para os descritores que não são sessões
+static int listener_tag;
+static int timer_tag;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void on_signal(int sig) {
+  (void)sig;
+  stop_requested = 1;
+}
+
+static void put_u16(uint8_t *out, uint16_t value) {
+  out[0] = (uint8_t)value;
+  out[1] = (uint8_t)(value >> 8);
+}
+
+static void put_u32(uint8_t *out, uint32_t value) {
+  for (int b = 0; b < 4; b++) {
+    out[b] = (uint8_t)(value >> (8 * b));
+  }
+}
+
+static uint32_t get_u32(const uint8_t *in) {
+  return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 |
+         (uint32_t)in[3] << 24;
+}
+
+static void watch_output(Server *server, Session *session, bool writing) {
+  if (session->writing == writing) {
+    return;
+  }
+  struct epoll_event event = {EPOLLIN | (writing ? EPOLLOUT : 0),
+                              {.ptr = session}};
+  epoll_ctl(server->epoll, EPOLL_CTL_MOD, session->fd, &event);
+  session->writing = writing;
+}
+
+// Envia o que couber sem bloquear; o resto sai quando vier EPOLLOUT
+static void flush_output(Server *server, Session *session) {
+  while (session->out_len > 0) {
+    ssize_t written = send(session->fd, &session->out[session->out_start],
+                           session->out_len, MSG_NOSIGNAL);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        session->closing = true;
+        return;
+      }
+      break;
+    }
+    session->out_start += (size_t)written;
+    session->out_len -= (size_t)written;
+    server->bytes += (uint64_t)written;
+  }
+  if (session->out_len == 0) {
+    session->out_start = 0;
+  }
+  watch_output(server, session, session->out_len > 0);
+}
+
+static bool load_session(Session *session, uint8_t quirks, const uint8_t *rom,
+                         size_t size) {
+  initCPU(session->chip);
+  set_quirks(session->chip, quirks);
+  session->loaded = initROMData(session->chip, rom, size);
+  session->dirty = true;
+  return session->loaded;
+}
+
+// Envia o frame atual se a tela mudou desde o último envio e o cliente não
+// está atrasado demais nos ACKs
+static void send_frame(Server *server, Session *session) {
+  const Screen *screen = &session->chip->screen;
+  const Screen *last = &session->history[session->sent % SERVER_HISTORY];
+  if (session->sent - session->acked >= SERVER_MAX_INFLIGHT) {
+    return;
+  }
+  if (memcmp(last->rows, screen->rows, sizeof(screen->rows)) == 0 &&
+      last->hires == screen->hires) {
+    session->dirty = false;
+    return;
+  }
+  if (session->out_start + session->out_len + SERVER_FRAME_HEADER +
+          DELTA_MAX_SIZE >
+      SERVER_OUT_SIZE) {
+    if (session->out_len + SERVER_FRAME_HEADER + DELTA_MAX_SIZE >
+        SERVER_OUT_SIZE) {
+      return; // Socket cheio: tenta no próximo frame
+    }
+    memmove(session->out, &session->out[session->out_start],
+            session->out_len);
+    session->out_start = 0;
+  }
+
+  uint8_t *out = &session->out[session->out_start + session->out_len];
+  const Screen *base = &session->history[session->acked % SERVER_HISTORY];
+  size_t size = delta_encode(base, screen, &out[SERVER_FRAME_HEADER]);
+  uint32_t seq = session->sent + 1;
+  out[0] = SERVER_MSG_FRAME;
+  out[1] = screen->hires ? SERVER_FRAME_HIRES : 0;
+  put_u16(&out[2], (uint16_t)size);
+  put_u32(&out[4], seq);
+  put_u32(&out[8], session->acked);
+  session->out_len += SERVER_FRAME_HEADER + size;
+
+  session->history[seq % SERVER_HISTORY] = *screen;
+  session->sent = seq;
+  session->dirty = false;
+  server->frames++;
+  flush_output(server, session);
+}
+
+static void tick(Server *server, uint64_t frames) {
+  if (frames > SERVER_MAX_CATCHUP) {
+    frames = SERVER_MAX_CATCHUP;
+  }
+  for (Session *session = server->sessions; session; session = session->next) {
+    if (!session->loaded || session->closing) {
+      continue;
+    }
+    for (uint64_t f = 0; f < frames; f++) {
+      run_frame(session->chip, &server->sched);
+    }
+    session->dirty |= session->chip->draw_flag;
+    session->chip->draw_flag = false;
+    if (session->dirty) {
+      send_frame(server, session);
+    }
+  }
+}
+
+// Tamanho da mensagem no início de msg: 0 se ainda não chegou inteira,
+// SIZE_MAX se for inválida
+static size_t message_length(const uint8_t *msg, size_t available) {
+  size_t length;
+  switch (msg[0]) {
+  case SERVER_MSG_KEY:
+  case SERVER_MSG_CHAR:
+    length = 3;
+    break;
+  case SERVER_MSG_ACK:
+    length = 5;
+    break;
+  case SERVER_MSG_LOAD:
+    if (available < SERVER_LOAD_HEADER) {
+      return 0;
+    }
+    length = (size_t)msg[2] | (size_t)msg[3] << 8;
+    if (length > SERVER_MAX_ROM) {
+      fprintf(stderr, "Erro: ROM de %zu bytes recusada.\n", length);
+      return SIZE_MAX;
+    }
+    length += SERVER_LOAD_HEADER;
+    break;
+  default:
+    return SIZE_MAX;
+  }
+  return available < length ? 0 : length;
+}
+
+static bool handle_message(Server *server, Session *session,
+                           const uint8_t *msg, size_t length) {
+  switch (msg[0]) {
+  case SERVER_MSG_KEY:
+  case SERVER_MSG_CHAR: {
+    int key = msg[0] == SERVER_MSG_KEY ? (msg[1] < KEYS ? msg[1] : -1)
+                                       : keymap_from_char(msg[1]);
+    if (key >= 0) {
+      session->chip->keys[key] = msg[2] != 0;
+    }
+    return true;
+  }
+  case SERVER_MSG_ACK: {
+    // Só avança, e só até o que já foi enviado
+    uint32_t seq = get_u32(&msg[1]);
+    if (seq - session->acked <= session->sent - session->acked) {
+      session->acked = seq;
+    }
+    return true;
+  }
+  default: {
+    uint8_t quirks =
+        msg[1] == SERVER_DEFAULT_QUIRKS ? server->quirks : msg[1];
+    return load_session(session, quirks, &msg[SERVER_LOAD_HEADER],
+                        length - SERVER_LOAD_HEADER);
+  }
+  }
+}
+
+// Consome as mensagens completas do buffer de entrada. false = protocolo
+// violado.
+static bool handle_messages(Server *server, Session *session) {
+  size_t pos = 0;
+  while (pos < session->in_len) {
+    const uint8_t *msg = &session->in[pos];
+    size_t length = message_length(msg, session->in_len - pos);
+    if (length == SIZE_MAX ||
+        (length > 0 && !handle_message(server, session, msg, length))) {
+      return false;
+    }
+    if (length == 0) {
+      break;
+    }
+    pos += length;
+  }
+  memmove(session->in, &session->in[pos], session->in_len - pos);
+  session->in_len -= pos;
+  return true;
+}
+
+static void read_input(Server *server, Session *session) {
+  for (;;) {
+    ssize_t got = recv(session->fd, &session->in[session->in_len],
+                       SERVER_IN_SIZE - session->in_len, 0);
+    if (got == 0) {
+      session->closing = true;
+      return;
+    }
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        session->closing = true;
+      }
+      return;
+    }
+    session->in_len += (size_t)got;
+    if (!handle_messages(server, session)) {
+      session->closing = true;
+      return;
+    }
+  }
+}
+
+static void accept_sessions(Server *server) {
+  for (;;) {
+    int fd = accept4(server->listener, NULL, NULL,
+                     SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        perror("Erro ao aceitar conexão");
+      }
+      return;
+    }
+    if (server->session_count >= server->max_sessions) {
+      fprintf(stderr, "Limite de %zu sessões atingido.\n",
+              server->max_sessions);
+      close(fd);
+      continue;
+    }
+
+    Session *session = (Session *)calloc(1, sizeof(Session));
+    CPU *chip = (CPU *)cache_aligned_alloc(sizeof(CPU));
+    if (session == NULL || chip == NULL) {
+      fprintf(stderr, "Erro: Falha ao alocar a sessão.\n");
+      free(session);
+      cache_aligned_free(chip);
+      close(fd);
+      continue;
+    }
+    session->fd = fd;
+    session->chip = chip;
+    initCPU(chip);
+    set_quirks(chip, server->quirks);
+    if (server->rom) {
+      load_session(session, server->quirks, server->rom, server->rom_size);
+    }
+
+    struct epoll_event event = {EPOLLIN, {.ptr = session}};
+    if (epoll_ctl(server->epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+      perror("Erro no epoll");
+      cache_aligned_free(chip);
+      free(session);
+      close(fd);
+      continue;
+    }
+    session->next = server->sessions;
+    server->sessions = session;
+    server->session_count++;
+    server->served++;
+  }
+}
+
+static void close_sessions(Server *server, bool all) {
+  Session **link = &server->sessions;
+  while (*link) {
+    Session *session = *link;
+    if (!all && !session->closing) {
+      link = &session->next;
+      continue;
+    }
+    *link = session->next;
+    close(session->fd); // Também sai do epoll
+    cache_aligned_free(session->chip);
+    free(session);
+    server->session_count--;
+  }
+}
+
+static int open_listener(const char *path) {
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(address.sun_path)) {
+    fprintf(stderr, "Erro: Caminho do socket longo demais: %s\n", path);
+    return -1;
+  }
+  strcpy(address.sun_path, path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    perror("Erro ao criar o socket");
+    return -1;
+  }
+  unlink(path);
+  if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+      listen(fd, SOMAXCONN) != 0) {
+    perror("Erro ao abrir o socket");
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static int open_timer(void) {
+  int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (fd < 0) {
+    perror("Erro ao criar o timer");
+    return -1;
+  }
+  struct itimerspec period = {{0, 1000000000L / TIMER_HZ},
+                              {0, 1000000000L / TIMER_HZ}};
+  timerfd_settime(fd, 0, &period, NULL);
+  return fd;
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr, "Uso: %s [opções] [rom]\n", prog);
+  fprintf(stderr, "  --socket ARQ        Caminho do socket (padrão %s)\n",
+          SERVER_DEFAULT_SOCKET);
+  fprintf(stderr, "  --ipf N             Instruções por frame\n");
+  fprintf(stderr, "  --quirks PERFIL     Perfil padrão das sessões\n");
+  fprintf(stderr, "  --max-sessions N    Conexões simultâneas (padrão %d)\n",
+          SERVER_DEFAULT_SESSIONS);
+  fprintf(stderr, "Sem rom, cada cliente envia a sua com LOAD.\n");
+}
+
+int main(int argc, char **argv) {
+  const char *socket_path = SERVER_DEFAULT_SOCKET;
+  const char *rom_path = NULL;
+  int quirks = QUIRKS_LEGACY;
+  static Server server;
+  initScheduler(&server.sched);
+  server.max_sessions = SERVER_DEFAULT_SESSIONS;
+
+  for (int a = 1; a < argc; a++) {
+    if (strcmp(argv[a], "--socket") == 0 && a + 1 < argc) {
+      socket_path = argv[++a];
+    } else if (strcmp(argv[a], "--ipf") == 0 && a + 1 < argc) {
+      int ipf = atoi(argv[++a]);
+      if (ipf <= 0) {
+        fprintf(stderr, "Erro: Valor inválido para --ipf: %s\n", argv[a]);
+        return -1;
+      }
+      server.sched.cycles_per_frame = (uint32_t)ipf;
+    } else if (strcmp(argv[a], "--quirks") == 0 && a + 1 < argc) {
+      quirks = quirks_from_name(argv[++a]);
+      if (quirks < 0) {
+        fprintf(stderr, "Erro: Perfil desconhecido: %s\n", argv[a]);
+        return -1;
+      }
+    } else if (strcmp(argv[a], "--max-sessions") == 0 && a + 1 < argc) {
+      int max = atoi(argv[++a]);
+      if (max <= 0) {
+        fprintf(stderr, "Erro: Valor inválido para --max-sessions: %s\n",
+                argv[a]);
+        return -1;
+      }
+      server.max_sessions = (size_t)max;
+    } else if (argv[a][0] == '-' && argv[a][1] == '-') {
+      usage(argv[0]);
+      return -1;
+    } else {
+      rom_path = argv[a];
+    }
+  }
+  server.quirks = (uint8_t)quirks;
+
+  FILEDRAM *file = NULL;
+  if (rom_path) {
+    file = initFILE(rom_path);
+    if (file == NULL) {
+      return -1;
+    }
+    if ((size_t)file->size > SERVER_MAX_ROM) {
+      printf("Erro: A ROM é muito grande para a memória do Chip-8.\n");
+      freeFILE(file);
+      return -1;
+    }
+    server.rom = file->buffer;
+    server.rom_size = (size_t)file->size;
+  }
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = on_signal; // Sem SA_RESTART: epoll_wait volta com EINTR
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+
+  server.epoll = epoll_create1(EPOLL_CLOEXEC);
+  server.listener = open_listener(socket_path);
+  server.timer = open_timer();
+  if (server.epoll < 0 || server.listener < 0 || server.timer < 0) {
+    return -1;
+  }
+  struct epoll_event listen_event = {EPOLLIN, {.ptr = &listener_tag}};
+  struct epoll_event timer_event = {EPOLLIN, {.ptr = &timer_tag}};
+  epoll_ctl(server.epoll, EPOLL_CTL_ADD, server.listener, &listen_event);
+  epoll_ctl(server.epoll, EPOLL_CTL_ADD, server.timer, &timer_event);
+  printf("Escutando em %s\n", socket_path);
+  fflush(stdout);
+
+  struct epoll_event events[SERVER_EVENTS];
+  while (!stop_requested) {
+    int count = epoll_wait(server.epoll, events, SERVER_EVENTS, -1);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("Erro no epoll");
+      break;
+    }
+    for (int e = 0; e < count; e++) {
+      void *ptr = events[e].data.ptr;
+      if (ptr == &listener_tag) {
+        accept_sessions(&server);
+      } else if (ptr == &timer_tag) {
+        uint64_t expirations = 0;
+        if (read(server.timer, &expirations, sizeof(expirations)) ==
+            sizeof(expirations)) {
+          tick(&server, expirations);
+        }
+      } else {
+        Session *session = (Session *)ptr;
+        if (session->closing) {
+          continue;
+        }
+        if (events[e].events & EPOLLIN) {
+          read_input(&server, session);
+        }
+        if (events[e].events & (EPOLLERR | EPOLLHUP)) {
+          session->closing = true;
+        } else if ((events[e].events & EPOLLOUT) && !session->closing) {
+          flush_output(&server, session);
+        }
+      }
+    }
+    // Só agora: eventos da mesma rodada ainda podiam apontar para elas
+    close_sessions(&server, false);
+  }
+
+  printf("%" PRIu64 " sessões atendidas, %" PRIu64 " frames, %" PRIu64
+         " bytes enviados\n",
+         server.served, server.frames, server.bytes);
+  close_sessions(&server, true);
+  close(server.timer);
+  close(server.listener);
+  close(server.epoll);
+  unlink(socket_path);
+  if (file) {
+    freeFILE(file);
+  }
+  return 0;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "delta.h"
+
+// Protocolo do chip8-server (tools/server.c) sobre um socket Unix de fluxo.
+// Inteiros em little-endian.
+//
+// Cliente -> servidor:
+//   KEY   [1][tecla 0-F][1 = apertada, 0 = solta]
+//   CHAR  [2][caractere][1 = apertada, 0 = solta]  mapeado como no teclado
+//         do frontend (1234/qwer/asdf/zxcv, ver keymap.h)
+//   ACK   [3][seq u32]  o cliente já tem o frame seq
+//   LOAD  [4][perfil][tamanho u16][ROM]  reinicia a sessão com outra ROM;
+//         perfil é um QUIRKS_* ou 0xFF para o padrão do servidor
+//
+// Servidor -> cliente:
+//   FRAME [0x81][flags][tamanho u16][seq u32][base u32][dados]
+//         dados (tamanho bytes) é delta_encode do frame base para o frame
+//         seq; flags bit 0 = alta resolução. O frame 0 é a tela apagada.
+//
+// A base é sempre o último frame confirmado com ACK, então o cliente guarda
+// os frames desde o último ACK (no máximo SERVER_MAX_INFLIGHT + 1). Sem
+// ACK o servidor para de enviar depois de SERVER_MAX_INFLIGHT frames, e uma
+// sessão cuja tela não muda não envia nada.
+#define SERVER_MSG_KEY 1
+#define SERVER_MSG_CHAR 2
+#define SERVER_MSG_ACK 3
+#define SERVER_MSG_LOAD 4
+#define SERVER_MSG_FRAME 0x81
+
+#define SERVER_FRAME_HIRES 0x01
+#define SERVER_FRAME_HEADER 12
+#define SERVER_LOAD_HEADER 4
+#define SERVER_DEFAULT_QUIRKS 0xFF
+#define SERVER_MAX_INFLIGHT 4
@@ -0,0 +1,97 @@
+// chip8-trace: lê um trace binário gravado com --trace e imprime uma linha
+// por instrução: ciclo, endereço, opcode, mnemônico, I e o registrador que
+// mudou.
+#include "decode.h"
+#include "trace.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void usage(const char *prog) {
+  fprintf(stderr, "Uso: %s [opções] <trace>\n", prog);
+  fprintf(stderr, "  --from C   Começa no ciclo C\n");
+  fprintf(stderr, "  --to C     Para depois do ciclo C\n");
+  fprintf(stderr, "  --pc ADDR  Só as instruções neste endereço\n");
+}
+
+int main(int argc, char **argv) {
+  const char *path = NULL;
+  uint64_t from = 0;
+  uint64_t to = UINT64_MAX;
+  long pc_filter = -1;
+
+  for (int a = 1; a < argc; a++) {
+    if (strcmp(argv[a], "--from") == 0 && a + 1 < argc) {
+      from = strtoull(argv[++a], NULL, 0);
+    } else if (strcmp(argv[a], "--to") == 0 && a + 1 < argc) {
+      to = strtoull(argv[++a], NULL, 0);
+    } else if (strcmp(argv[a], "--pc") == 0 && a + 1 < argc) {
+      pc_filter = strtol(argv[++a], NULL, 0);
+    } else if (argv[a][0] == '-' && argv[a][1] == '-') {
+      usage(argv[0]);
+      return -1;
+    } else {
+      path = argv[a];
+    }
+  }
+  if (path == NULL) {
+    usage(argv[0]);
+    return -1;
+  }
+
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    perror("Erro ao abrir o trace");
+    return -1;
+  }
+  TraceHeader header;
+  if (fread(&header, sizeof(header), 1, file) != 1 ||
+      header.magic != TRACE_MAGIC || header.version != TRACE_VERSION) {
+    fprintf(stderr, "Erro: %s não é um trace válido.\n", path);
+    fclose(file);
+    return -1;
+  }
+
+  printf("# perfil %s, início no ciclo %" PRIu64 ", PC 0x%03X, I 0x%03X\n#",
+         quirks_name((uint8_t)header.quirks), header.start_cycle, header.pc,
+         header.i);
+  for (int r = 0; r < NUM_REGISTERS; r++) {
+    printf(" V%X=%02X", r, header.v[r]);
+  }
+  printf("\n");
+
+  TraceRecord record;
+  uint64_t expected = header.start_cycle;
+  uint64_t count = 0;
+  while (fread(&record, sizeof(record), 1, file) == 1) {
+    if (record.cycle > to) {
+      break;
+    }
+    count++;
+    if (record.cycle < expected && record.cycle >= from) {
+      // Estado carregado ou rewind durante a gravação
+      printf("# volta para o ciclo %" PRIu64 "\n", record.cycle);
+    } else if (record.cycle != expected && record.cycle >= from) {
+      printf("# %" PRIu64 " instruções sem registro\n", record.cycle - expected);
+    }
+    expected = record.cycle + 1;
+    if (record.cycle < from || (pc_filter >= 0 && record.pc != pc_filter)) {
+      continue;
+    }
+    char text[32];
+    disassemble(record.opcode, (uint8_t)header.quirks, text, sizeof(text));
+    printf("%10" PRIu64 "  %03X  %04X  %-18s I=%03X", record.cycle, record.pc,
+           record.opcode, text, record.i);
+    if (record.reg != TRACE_NO_REG) {
+      printf("  V%X=%02X", record.reg, record.value);
+    }
+    printf("\n");
+  }
+  if (ferror(file)) {
+    fprintf(stderr, "Erro ao ler o trace.\n");
+  }
+  fclose(file);
+  fprintf(stderr, "%" PRIu64 " registros lidos.\n", count);
+  return 0;
+}